@@ -32,18 +32,68 @@
 #include "plugininfo.h"
 #include "nymeasettings.h"
 #include "integrationpluginzigbee.h"
+#include "zigbeetrace.h"
 
-#include <QDateTime>
+#include "xiaomi/xiaomibuttonsensorhandler.h"
+#include "xiaomi/xiaomimotionsensorhandler.h"
+#include "xiaomi/xiaomimagnetsensorhandler.h"
+#include "xiaomi/xiaomitemperaturesensorhandler.h"
+
+#include <QFile>
 #include <QSerialPortInfo>
 
-IntegrationPluginZigbee::IntegrationPluginZigbee()
+// Action::triggeredBy() is not available in all supported libnymea versions
+template <typename T>
+static auto isTriggeredByUser(const T &action, int) -> decltype(action.triggeredBy() == T::TriggeredByUser)
 {
+    return action.triggeredBy() == T::TriggeredByUser;
+}
 
+// Without the origin, all actions get sent right away like before the command scheduler
+template <typename T>
+static bool isTriggeredByUser(const T &action, long)
+{
+    Q_UNUSED(action)
+    return true;
 }
 
-void IntegrationPluginZigbee::init()
-{       
+IntegrationPluginZigbee::IntegrationPluginZigbee()
+{
+    m_ieeeAddressParamTypeIds[zigbeeNodeThingClassId] = zigbeeNodeThingIeeeAddressParamTypeId;
+    m_ieeeAddressParamTypeIds[xiaomiTemperatureHumidityThingClassId] = xiaomiTemperatureHumidityThingIeeeAddressParamTypeId;
+    m_ieeeAddressParamTypeIds[xiaomiMagnetSensorThingClassId] = xiaomiMagnetSensorThingIeeeAddressParamTypeId;
+    m_ieeeAddressParamTypeIds[xiaomiButtonSensorThingClassId] = xiaomiButtonSensorThingIeeeAddressParamTypeId;
+    m_ieeeAddressParamTypeIds[xiaomiMotionSensorThingClassId] = xiaomiMotionSensorThingIeeeAddressParamTypeId;
+
+    // Known devices by Basic cluster model identifier
+    m_deviceDefinitions.addDefinition("lumi.sensor_ht", xiaomiTemperatureHumidityThingClassId, xiaomiTemperatureHumidityThingIeeeAddressParamTypeId, QT_TR_NOOP("Xiaomi temperature and humidity sensor"));
+    m_deviceDefinitions.addDefinition("lumi.sensor_magnet", xiaomiMagnetSensorThingClassId, xiaomiMagnetSensorThingIeeeAddressParamTypeId, QT_TR_NOOP("Xiaomi magnet sensor"));
+    m_deviceDefinitions.addDefinition("lumi.sensor_switch", xiaomiButtonSensorThingClassId, xiaomiButtonSensorThingIeeeAddressParamTypeId, QT_TR_NOOP("Xiaomi button"));
+    m_deviceDefinitions.addDefinition("lumi.sensor_motion", xiaomiMotionSensorThingClassId, xiaomiMotionSensorThingIeeeAddressParamTypeId, QT_TR_NOOP("Xiaomi motion sensor"));
+}
 
+void IntegrationPluginZigbee::init()
+{
+    m_attributeRouter = new ZigbeeAttributeRouter(this);
+    m_timerWheel = new ZigbeeTimerWheel(50, 256, this);
+
+    // Last known topology and values, so things don't have to wait for the next report after a restart
+    m_snapshot = new ZigbeeNodeSnapshot(NymeaSettings::settingsPath() + "/nymea-zigbee-snapshot.bin", this);
+    m_snapshot->load();
+    m_attributeRouter->setSnapshot(m_snapshot);
+
+    // Fail the setup before nymea aborts it
+    m_setupQueue = new ZigbeeSetupQueue(m_timerWheel, 25000, this);
+
+    // Controller statistics, only running while there is a controller
+    m_statisticsTimer = new QTimer(this);
+    m_statisticsTimer->setInterval(10000);
+    connect(m_statisticsTimer, &QTimer::timeout, this, &IntegrationPluginZigbee::onStatisticsTimeout);
+
+    registerThingHandler(new XiaomiTemperatureSensorHandler(this));
+    registerThingHandler(new XiaomiMagnetSensorHandler(this));
+    registerThingHandler(new XiaomiButtonSensorHandler(this));
+    registerThingHandler(new XiaomiMotionSensorHandler(this));
 }
 
 void IntegrationPluginZigbee::startMonitoringAutoThings()
@@ -55,29 +105,9 @@ void IntegrationPluginZigbee::postSetupThing(Thing *thing)
 {
     qCDebug(dcZigbee()) << "Post setup device" << thing->name() << thing->params();
 
-    if (thing->thingClassId() == xiaomiTemperatureHumidityThingClassId) {
-        XiaomiTemperatureSensor *sensor = m_xiaomiTemperatureSensors.value(thing);
-        thing->setStateValue(xiaomiTemperatureHumidityConnectedStateTypeId, sensor->connected());
-        thing->setStateValue(xiaomiTemperatureHumidityTemperatureStateTypeId, sensor->temperature());
-        thing->setStateValue(xiaomiTemperatureHumidityHumidityStateTypeId, sensor->humidity());
-    }
-
-    if (thing->thingClassId() == xiaomiMagnetSensorThingClassId) {
-        XiaomiMagnetSensor *sensor = m_xiaomiMagnetSensors.value(thing);
-        thing->setStateValue(xiaomiMagnetSensorConnectedStateTypeId, sensor->connected());
-        thing->setStateValue(xiaomiMagnetSensorClosedStateTypeId, sensor->closed());
-    }
-
-    if (thing->thingClassId() == xiaomiButtonSensorThingClassId) {
-        XiaomiButtonSensor *sensor = m_xiaomiButtonSensors.value(thing);
-        thing->setStateValue(xiaomiButtonSensorConnectedStateTypeId, sensor->connected());
-        //device->setStateValue(xiaomiButtonSensorPressedStateTypeId, sensor->pressed());
-    }
-
-    if (thing->thingClassId() == xiaomiMotionSensorThingClassId) {
-        XiaomiMotionSensor *sensor = m_xiaomiMotionSensors.value(thing);
-        thing->setStateValue(xiaomiMotionSensorConnectedStateTypeId, sensor->connected());
-        thing->setStateValue(xiaomiMotionSensorIsPresentStateTypeId, sensor->present());
+    ZigbeeThingHandler *handler = m_thingHandlers.value(thing->thingClassId());
+    if (handler) {
+        handler->postSetupThing(thing);
     }
 }
 
@@ -85,31 +115,25 @@ void IntegrationPluginZigbee::thingRemoved(Thing *thing)
 {
     qCDebug(dcZigbee()) << "Remove device" << thing->name() << thing->params();
 
-    if (thing->thingClassId() == zigbeeControllerThingClassId) {
-        ZigbeeNetworkManager *zigbeeNetworkManager = m_zigbeeControllers.take(thing);
-        if (zigbeeNetworkManager) {
-            zigbeeNetworkManager->deleteLater();
+    if (m_ieeeAddressParamTypeIds.contains(thing->thingClassId())) {
+        ZigbeeAddress ieeeAddress(thing->paramValue(m_ieeeAddressParamTypeIds.value(thing->thingClassId())).toString());
+        if (m_nodeThings.value(ieeeAddress.toUInt64()) == thing) {
+            m_nodeThings.remove(ieeeAddress.toUInt64());
         }
     }
 
-    if (thing->thingClassId() == xiaomiTemperatureHumidityThingClassId) {
-        XiaomiTemperatureSensor *sensor = m_xiaomiTemperatureSensors.take(thing);
-        sensor->deleteLater();
-    }
-
-    if (thing->thingClassId() == xiaomiMagnetSensorThingClassId) {
-        XiaomiMagnetSensor *sensor = m_xiaomiMagnetSensors.take(thing);
-        sensor->deleteLater();
-    }
-
-    if (thing->thingClassId() == xiaomiButtonSensorThingClassId) {
-        XiaomiButtonSensor *sensor = m_xiaomiButtonSensors.take(thing);
-        sensor->deleteLater();
-    }
+    ZigbeeThingHandler *handler = m_thingHandlers.value(thing->thingClassId());
+    if (handler) {
+        handler->thingRemoved(thing);
+    } else if (thing->thingClassId() == zigbeeControllerThingClassId) {
+        ZigbeeNetworkThread *zigbeeNetwork = m_zigbeeControllers.take(thing);
+        if (zigbeeNetwork) {
+            zigbeeNetwork->deleteLater();
+        }
 
-    if (thing->thingClassId() == xiaomiMotionSensorThingClassId) {
-        XiaomiMotionSensor *sensor = m_xiaomiMotionSensors.take(thing);
-        sensor->deleteLater();
+        if (m_zigbeeControllers.values().isEmpty()) {
+            m_statisticsTimer->stop();
+        }
     }
 }
 
@@ -153,100 +177,72 @@ void IntegrationPluginZigbee::setupThing(ThingSetupInfo *info)
     Thing *thing = info->thing();
     qCDebug(dcZigbee()) << "Setup device" << thing->name() << thing->params();
 
-    if (thing->thingClassId() == zigbeeControllerThingClassId) {
-        qCDebug(dcZigbee()) << "Create zigbee network manager for controller" << thing;
-        ZigbeeNetworkManager *zigbeeNetworkManager = new ZigbeeNetworkManager(this);
-        zigbeeNetworkManager->setSerialPortName(thing->paramValue(zigbeeControllerThingSerialPortParamTypeId).toString());
-        zigbeeNetworkManager->setSerialBaudrate(static_cast<qint32>(thing->paramValue(zigbeeControllerThingBaudrateParamTypeId).toUInt()));
-        zigbeeNetworkManager->setSettingsFileName(NymeaSettings::settingsPath() + "/nymea-zigbee.conf");
-
-        connect(zigbeeNetworkManager, &ZigbeeNetworkManager::stateChanged, this, &IntegrationPluginZigbee::onZigbeeControllerStateChanged);
-        connect(zigbeeNetworkManager, &ZigbeeNetworkManager::channelChanged, this, &IntegrationPluginZigbee::onZigbeeControllerChannelChanged);
-        connect(zigbeeNetworkManager, &ZigbeeNetworkManager::extendedPanIdChanged, this, &IntegrationPluginZigbee::onZigbeeControllerPanIdChanged);
-        connect(zigbeeNetworkManager, &ZigbeeNetworkManager::permitJoiningChanged, this, &IntegrationPluginZigbee::onZigbeeControllerPermitJoiningChanged);
-        connect(zigbeeNetworkManager, &ZigbeeNetworkManager::nodeAdded, this, &IntegrationPluginZigbee::onZigbeeControllerNodeAdded);
-        connect(zigbeeNetworkManager, &ZigbeeNetworkManager::nodeRemoved, this, &IntegrationPluginZigbee::onZigbeeControllerNodeRemoved);
-
-        m_zigbeeControllers.insert(thing, zigbeeNetworkManager);
-
-        zigbeeNetworkManager->startNetwork();
-    }
-
-    if (thing->thingClassId() == xiaomiTemperatureHumidityThingClassId) {
-        qCDebug(dcZigbee()) << "Xiaomi temperature humidiry sensor" << thing;
-        ZigbeeAddress ieeeAddress(thing->paramValue(xiaomiTemperatureHumidityThingIeeeAddressParamTypeId).toString());
-        // Get the parent controller and node for this device
-        ZigbeeNetworkManager *zigbeeNetworkManager = findParentController(thing);
-        ZigbeeNode *node = zigbeeNetworkManager->getZigbeeNode(ieeeAddress);
-
-        if (!node) {
-            qCWarning(dcZigbee()) << "Could not find node for this device. The setup failed";
-            return info->finish(Thing::ThingErrorSetupFailed);
-        }
-
-        XiaomiTemperatureSensor *sensor = new XiaomiTemperatureSensor(node, this);
-        connect(sensor, &XiaomiTemperatureSensor::connectedChanged, this, &IntegrationPluginZigbee::onXiaomiTemperatureSensorConnectedChanged);
-        connect(sensor, &XiaomiTemperatureSensor::temperatureChanged, this, &IntegrationPluginZigbee::onXiaomiTemperatureSensorTemperatureChanged);
-        connect(sensor, &XiaomiTemperatureSensor::humidityChanged, this, &IntegrationPluginZigbee::onXiaomiTemperatureSensorHumidityChanged);
-        m_xiaomiTemperatureSensors.insert(thing, sensor);
+    // Index the node address right away, so the node doesn't get adopted twice while the setup is pending.
+    // A failed or aborted setup deletes the thing without calling thingRemoved(), so it gets dropped again then.
+    ZigbeeAddress ieeeAddress;
+    if (m_ieeeAddressParamTypeIds.contains(thing->thingClassId())) {
+        ieeeAddress = ZigbeeAddress(thing->paramValue(m_ieeeAddressParamTypeIds.value(thing->thingClassId())).toString());
+        quint64 nodeAddress = ieeeAddress.toUInt64();
+        m_nodeThings.insert(nodeAddress, thing);
+
+        auto dropThing = [this, nodeAddress, thing](){
+            if (m_nodeThings.value(nodeAddress) == thing) {
+                m_nodeThings.remove(nodeAddress);
+            }
+        };
+        connect(info, &ThingSetupInfo::aborted, this, dropThing);
+        connect(info, &ThingSetupInfo::finished, this, [info, dropThing](){
+            if (info->status() != Thing::ThingErrorNoError) {
+                dropThing();
+            }
+        });
     }
 
-
-    if (thing->thingClassId() == xiaomiMagnetSensorThingClassId) {
-        qCDebug(dcZigbee()) << "Xiaomi magnet sensor" << thing;
-        ZigbeeAddress ieeeAddress(thing->paramValue(xiaomiMagnetSensorThingIeeeAddressParamTypeId).toString());
-        // Get the parent controller and node for this device
-        ZigbeeNetworkManager *zigbeeNetworkManager = findParentController(thing);
-        ZigbeeNode *node = zigbeeNetworkManager->getZigbeeNode(ieeeAddress);
-        if (!node) {
-            qCWarning(dcZigbee()) << "Could not find node for this device. The setup failed";
-            return info->finish(Thing::ThingErrorSetupFailed);
+    ZigbeeThingHandler *handler = m_thingHandlers.value(thing->thingClassId());
+    if (handler) {
+        // Nodes known from the last run get restored, so things come up before the network does
+        ZigbeeNetworkThread *zigbeeNetwork = findParentController(thing);
+        if (zigbeeNetwork && !zigbeeNetwork->node(ieeeAddress.toUInt64()) && m_snapshot->hasNode(ieeeAddress.toUInt64())) {
+            qCDebug(dcZigbee()) << "Restore node" << ieeeAddress.toString() << "from the snapshot";
+            zigbeeNetwork->restoreNode(m_snapshot->node(ieeeAddress.toUInt64()));
         }
 
-        XiaomiMagnetSensor *sensor = new XiaomiMagnetSensor(node, this);
-        connect(sensor, &XiaomiMagnetSensor::connectedChanged, this, &IntegrationPluginZigbee::onXiaomiMagnetSensorConnectedChanged);
-        connect(sensor, &XiaomiMagnetSensor::closedChanged, this, &IntegrationPluginZigbee::onXiaomiMagnetSensorClosedChanged);
-
-        m_xiaomiMagnetSensors.insert(thing, sensor);
-    }
-
-    if (thing->thingClassId() == xiaomiButtonSensorThingClassId) {
-        qCDebug(dcZigbee()) << "Xiaomi button sensor" << thing;
-        ZigbeeAddress ieeeAddress(thing->paramValue(xiaomiButtonSensorThingIeeeAddressParamTypeId).toString());
-        // Get the parent controller and node for this device
-        ZigbeeNetworkManager *zigbeeNetworkManager = findParentController(thing);
-        ZigbeeNode *node = zigbeeNetworkManager->getZigbeeNode(ieeeAddress);
-        if (!node) {
-            qCWarning(dcZigbee()) << "Could not find node for this device. The setup failed";
-            return info->finish(Thing::ThingErrorSetupFailed);
+        // Wait for the network to know the node instead of failing the setup
+        if (!zigbeeNetwork || !zigbeeNetwork->node(ieeeAddress.toUInt64())) {
+            m_setupQueue->park(ieeeAddress.toUInt64(), info);
+            return;
         }
 
-        XiaomiButtonSensor *sensor = new XiaomiButtonSensor(node, this);
-        connect(sensor, &XiaomiButtonSensor::connectedChanged, this, &IntegrationPluginZigbee::onXiaomiButtonSensorConnectedChanged);
-        connect(sensor, &XiaomiButtonSensor::pressedChanged, this, &IntegrationPluginZigbee::onXiaomiButtonSensorPressedChanged);
-        connect(sensor, &XiaomiButtonSensor::buttonPressed, this, &IntegrationPluginZigbee::onXiaomiButtonSensorPressed);
-        connect(sensor, &XiaomiButtonSensor::buttonLongPressed, this, &IntegrationPluginZigbee::onXiaomiButtonSensorLongPressed);
-
-        m_xiaomiButtonSensors.insert(thing, sensor);
+        handler->setupThing(info);
+        return;
     }
 
-    if (thing->thingClassId() == xiaomiMotionSensorThingClassId) {
-        qCDebug(dcZigbee()) << "Xiaomi motion sensor" << thing;
-        ZigbeeAddress ieeeAddress(thing->paramValue(xiaomiMotionSensorThingIeeeAddressParamTypeId).toString());
-        // Get the parent controller and node for this device
-        ZigbeeNetworkManager *zigbeeNetworkManager = findParentController(thing);
-        ZigbeeNode *node = zigbeeNetworkManager->getZigbeeNode(ieeeAddress);
-        if (!node) {
-            qCWarning(dcZigbee()) << "Could not find node for this device. The setup failed";
-            return info->finish(Thing::ThingErrorSetupFailed);
-        }
-
-        XiaomiMotionSensor *sensor = new XiaomiMotionSensor(node, this);
-        connect(sensor, &XiaomiMotionSensor::connectedChanged, this, &IntegrationPluginZigbee::onXiaomiMotionSensorConnectedChanged);
-        connect(sensor, &XiaomiMotionSensor::presentChanged, this, &IntegrationPluginZigbee::onXiaomiMotionSensorPresentChanged);
-        connect(sensor, &XiaomiMotionSensor::motionDetected, this, &IntegrationPluginZigbee::onXiaomiMotionSensorMotionDetected);
-
-        m_xiaomiMotionSensors.insert(thing, sensor);
+    if (thing->thingClassId() == zigbeeControllerThingClassId) {
+        qCDebug(dcZigbee()) << "Create zigbee network manager for controller" << thing;
+        ZigbeeNetworkThread *zigbeeNetwork = new ZigbeeNetworkThread(this);
+
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::stateChanged, this, &IntegrationPluginZigbee::onZigbeeControllerStateChanged);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::channelChanged, this, &IntegrationPluginZigbee::onZigbeeControllerChannelChanged);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::extendedPanIdChanged, this, &IntegrationPluginZigbee::onZigbeeControllerPanIdChanged);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::permitJoiningChanged, this, &IntegrationPluginZigbee::onZigbeeControllerPermitJoiningChanged);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::nodeAdded, this, &IntegrationPluginZigbee::onZigbeeControllerNodeAdded);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::nodeInterviewed, this, &IntegrationPluginZigbee::onZigbeeControllerNodeAdded);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::nodeRemoved, this, &IntegrationPluginZigbee::onZigbeeControllerNodeRemoved);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::nodeConnectedChanged, m_attributeRouter, &ZigbeeAttributeRouter::onNodeConnectedChanged);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::attributeChanged, m_attributeRouter, &ZigbeeAttributeRouter::onAttributeChanged);
+        connect(zigbeeNetwork, &ZigbeeNetworkThread::statisticsTaken, this, &IntegrationPluginZigbee::onZigbeeControllerStatisticsTaken);
+
+        m_zigbeeControllers.insert(thing, zigbeeNetwork);
+        m_statisticsTimer->start();
+
+        // A replayed network must not touch the settings of the real one
+        QString replayFileName = thing->paramValue(zigbeeControllerThingReplayFileParamTypeId).toString();
+        QString settingsFileName = NymeaSettings::settingsPath() + (replayFileName.isEmpty() ? "/nymea-zigbee.conf" : "/nymea-zigbee-replay.conf");
+        zigbeeNetwork->setSerialCapture(thing->paramValue(zigbeeControllerThingCaptureFileParamTypeId).toString());
+        zigbeeNetwork->setSerialReplay(replayFileName, thing->paramValue(zigbeeControllerThingReplayRealTimeParamTypeId).toBool());
+        zigbeeNetwork->startNetwork(thing->paramValue(zigbeeControllerThingSerialPortParamTypeId).toString(),
+                                    static_cast<qint32>(thing->paramValue(zigbeeControllerThingBaudrateParamTypeId).toUInt()),
+                                    settingsFileName);
     }
 
     info->finish(Thing::ThingErrorNoError);
@@ -258,13 +254,41 @@ void IntegrationPluginZigbee::executeAction(ThingActionInfo *info)
     Action action = info->action();
     qCDebug(dcZigbee()) << "Executing action for device" << thing ->name() << action.actionTypeId().toString() << action.params();
 
+    ZigbeeThingHandler *handler = m_thingHandlers.value(thing->thingClassId());
+    if (handler) {
+        handler->executeAction(info);
+        return;
+    }
+
     if (thing->thingClassId() == zigbeeControllerThingClassId) {
-        ZigbeeNetworkManager *networkManager = m_zigbeeControllers.value(thing );
-        if (networkManager->state() != ZigbeeNetworkManager::StateRunning)
+        ZigbeeNetworkThread *zigbeeNetwork = m_zigbeeControllers.value(thing);
+        if (action.actionTypeId() == zigbeeControllerDumpDiagnosticsActionTypeId) {
+#ifdef ZIGBEE_TRACING
+            ZigbeeTrace::dump();
+#else
+            qCInfo(dcZigbee()) << "Report tracing is not available, the plugin has been built without CONFIG+=zigbee_tracing";
+#endif
+            m_eventLog.dump();
+            zigbeeNetwork->topology().dump();
+
+            // The topology is easier to read as graph, e.g. with "dot -Tsvg"
+            QFile topologyFile(NymeaSettings::settingsPath() + "/nymea-zigbee-topology-" + thing->id().toString().remove('{').remove('}') + ".dot");
+            if (topologyFile.open(QFile::WriteOnly | QFile::Truncate)) {
+                topologyFile.write(zigbeeNetwork->topology().toDot());
+                qCInfo(dcZigbee()) << "Topology written to" << topologyFile.fileName();
+            }
+            return info->finish(Thing::ThingErrorNoError);
+        }
+
+        if (zigbeeNetwork->state() != ZigbeeNetwork::StateRunning)
             return info->finish(Thing::ThingErrorHardwareNotAvailable);
 
+        if (action.actionTypeId() == zigbeeControllerCrawlTopologyActionTypeId)
+            zigbeeNetwork->crawlTopology();
+
+        ZigbeeCommandScheduler::Priority priority = commandPriority(action);
         if (action.actionTypeId() == zigbeeControllerFactoryResetActionTypeId)
-            networkManager->factoryResetNetwork();
+            zigbeeNetwork->factoryResetNetwork(priority);
 
 //        if (action.actionTypeId() == zigbeeControllerTouchlinkActionTypeId)
 //            networkManager->controller()->commandInitiateTouchLink();
@@ -273,17 +297,15 @@ void IntegrationPluginZigbee::executeAction(ThingActionInfo *info)
 //            networkManager->controller()->commandTouchLinkFactoryReset();
 
         if (action.actionTypeId() == zigbeeControllerPermitJoinActionTypeId)
-            networkManager->setPermitJoining(action.params().paramValue(zigbeeControllerPermitJoinActionPermitJoinParamTypeId).toBool());
+            zigbeeNetwork->setPermitJoining(action.params().paramValue(zigbeeControllerPermitJoinActionPermitJoinParamTypeId).toBool(), priority);
 
-    }
-
-    if (thing->thingClassId() == zigbeeNodeThingClassId) {
-        ZigbeeNetworkManager *networkManager = findParentController(thing );
+    } else if (thing->thingClassId() == zigbeeNodeThingClassId) {
+        ZigbeeNetworkThread *zigbeeNetwork = findParentController(thing);
 
-        if (!networkManager)
+        if (!zigbeeNetwork)
             return info->finish(Thing::ThingErrorHardwareFailure);
 
-        if (networkManager->state() != ZigbeeNetworkManager::StateRunning)
+        if (zigbeeNetwork->state() != ZigbeeNetwork::StateRunning)
             return info->finish(Thing::ThingErrorHardwareNotAvailable);
 
         quint16 shortAddress = static_cast<quint16>(thing ->paramValue(zigbeeNodeThingNwkAddressParamTypeId).toUInt());
@@ -294,201 +316,112 @@ void IntegrationPluginZigbee::executeAction(ThingActionInfo *info)
         }
 
         if (action.actionTypeId() == zigbeeNodeLqiRequestActionTypeId) {
-            networkManager->controller()->commandRequestLinkQuality(shortAddress);
+            zigbeeNetwork->requestLinkQuality(shortAddress, commandPriority(action));
         }
     }
 
     return info->finish(Thing::ThingErrorNoError);
 }
 
-ZigbeeNetworkManager *IntegrationPluginZigbee::findParentController(Thing *thing) const
+ZigbeeCommandScheduler::Priority IntegrationPluginZigbee::commandPriority(const Action &action) const
 {
-    foreach (Thing *t, myThings()) {
-        if (t->thingClassId() == zigbeeControllerThingClassId && t->id() == thing->parentId()) {
-            return m_zigbeeControllers.value(t);
-        }
-    }
+    // Somebody is waiting for actions triggered by hand, rules and scripts can wait a bit
+    if (isTriggeredByUser(action, 0))
+        return ZigbeeCommandScheduler::PriorityUser;
 
-    return nullptr;
+    return ZigbeeCommandScheduler::PriorityRule;
 }
 
-ZigbeeNetworkManager *IntegrationPluginZigbee::findNodeController(ZigbeeNode *node) const
+void IntegrationPluginZigbee::registerThingHandler(ZigbeeThingHandler *handler)
 {
-    foreach (ZigbeeNetworkManager *controller, m_zigbeeControllers.values()) {
-        if (controller->nodes().contains(node)) {
-            return controller;
-        }
-    }
+    m_thingHandlers.insert(handler->thingClassId(), handler);
+}
 
-    return nullptr;
+ZigbeeNetworkThread *IntegrationPluginZigbee::findParentController(Thing *thing) const
+{
+    return m_zigbeeControllers.value(thing->parentId());
 }
 
-Thing *IntegrationPluginZigbee::findNodeThing(ZigbeeNode *node)
+ZigbeeAttributeRouter *IntegrationPluginZigbee::attributeRouter() const
 {
-    foreach (Thing *thing, myThings()) {
-        ZigbeeAddress deviceIeeeAddress;
-        if (thing->thingClassId() == zigbeeNodeThingClassId) {
-            deviceIeeeAddress = ZigbeeAddress (thing->paramValue(zigbeeNodeThingIeeeAddressParamTypeId).toString());
-        }
+    return m_attributeRouter;
+}
 
-        if (thing->thingClassId() == xiaomiTemperatureHumidityThingClassId) {
-            deviceIeeeAddress = ZigbeeAddress (thing->paramValue(xiaomiTemperatureHumidityThingIeeeAddressParamTypeId).toString());
-        }
+ZigbeeTimerWheel *IntegrationPluginZigbee::timerWheel() const
+{
+    return m_timerWheel;
+}
 
-        if (thing->thingClassId() == xiaomiMagnetSensorThingClassId) {
-            deviceIeeeAddress = ZigbeeAddress (thing->paramValue(xiaomiMagnetSensorThingIeeeAddressParamTypeId).toString());
-        }
+ZigbeeEventLog *IntegrationPluginZigbee::eventLog()
+{
+    return &m_eventLog;
+}
 
-        if (thing->thingClassId() == xiaomiButtonSensorThingClassId) {
-            deviceIeeeAddress = ZigbeeAddress (thing->paramValue(xiaomiButtonSensorThingIeeeAddressParamTypeId).toString());
-        }
+Thing *IntegrationPluginZigbee::findNodeThing(quint64 ieeeAddress)
+{
+    return m_nodeThings.value(ieeeAddress);
+}
 
-        if (thing->thingClassId() == xiaomiMotionSensorThingClassId) {
-            deviceIeeeAddress = ZigbeeAddress (thing->paramValue(xiaomiMotionSensorThingIeeeAddressParamTypeId).toString());
-        }
+void IntegrationPluginZigbee::completePendingSetups(ZigbeeNetworkThread *zigbeeNetwork)
+{
+    if (m_setupQueue->isEmpty())
+        return;
 
-        if (node->extendedAddress() == deviceIeeeAddress) {
-            return thing;
-        }
-    }
+    foreach (const ZigbeeNodeInfo &node, zigbeeNetwork->nodes()) {
+        ThingSetupInfo *info = m_setupQueue->take(node.ieeeAddress);
+        if (!info)
+            continue;
 
-    return nullptr;
+        qCDebug(dcZigbee()) << "Continue setup of" << info->thing()->name() << "for" << ZigbeeAddress(node.ieeeAddress).toString();
+        m_thingHandlers.value(info->thing()->thingClassId())->setupThing(info);
+    }
 }
 
-void IntegrationPluginZigbee::createThingForNode(Thing *parentThing, ZigbeeNode *node)
+bool IntegrationPluginZigbee::createThingDescriptor(Thing *parentThing, const ZigbeeNodeInfo &node, ThingDescriptor *descriptor)
 {
     // We already know this device ieee address has not already been added
     // Try to figure out which device this is from the node properties and cluster information
 
-    if (node->hasOutputCluster(Zigbee::ClusterIdBasic)) {
-        ZigbeeCluster *basicCluster = node->getOutputCluster(Zigbee::ClusterIdBasic);
-        if (basicCluster->hasAttribute(Zigbee::ClusterAttributeBasicModelIdentifier)) {
-            QString modelIdentifier = QString::fromUtf8(basicCluster->attribute(Zigbee::ClusterAttributeBasicModelIdentifier).data());
-
-            // Xiaomi HT Sensor
-            if (modelIdentifier.contains("lumi.sensor_ht")) {
-                qCDebug(dcZigbee()) << "Xiaomi humidity/temperature sensor added";
-
-                qCDebug(dcZigbee()) << "Output cluster:";
-                foreach (ZigbeeCluster *cluster, node->outputClusters()) {
-                    qCDebug(dcZigbee()) << "    " << cluster;
-                }
-
-                qCDebug(dcZigbee()) << "Input cluster:";
-                foreach (ZigbeeCluster *cluster, node->inputClusters()) {
-                    qCDebug(dcZigbee()) << "    " << cluster;
-                }
-
-                ThingDescriptor descriptor(xiaomiTemperatureHumidityThingClassId);
-                descriptor.setParentId(parentThing->id());
-                descriptor.setTitle(tr("Xiaomi temperature and humidity sensor"));
-
-                ParamList params;
-                params.append(Param(xiaomiTemperatureHumidityThingIeeeAddressParamTypeId, node->extendedAddress().toString()));
-                descriptor.setParams(params);
-
-                emit autoThingsAppeared({ descriptor });
-                return;
-            }
-
-            // Xiaomi Magnet Sensor
-            if (modelIdentifier.contains("lumi.sensor_magnet")) {
-                qCDebug(dcZigbee()) << "Xiaomi magnet sensor added";
-
-                qCDebug(dcZigbee()) << "Output cluster:";
-                foreach (ZigbeeCluster *cluster, node->outputClusters()) {
-                    qCDebug(dcZigbee()) << "    " << cluster;
-                }
+    if (!node.hasOutputCluster(Zigbee::ClusterIdBasic))
+        return false;
 
-                qCDebug(dcZigbee()) << "Input cluster:";
-                foreach (ZigbeeCluster *cluster, node->inputClusters()) {
-                    qCDebug(dcZigbee()) << "    " << cluster;
-                }
+    if (!node.hasAttribute(Zigbee::ClusterIdBasic, Zigbee::ClusterAttributeBasicModelIdentifier))
+        return false;
 
-                ThingDescriptor descriptor(xiaomiMagnetSensorThingClassId);
-                descriptor.setParentId(parentThing->id());
-                descriptor.setTitle(tr("Xiaomi magnet sensor"));
-
-                ParamList params;
-                params.append(Param(xiaomiMagnetSensorThingIeeeAddressParamTypeId, node->extendedAddress().toString()));
-                descriptor.setParams(params);
-
-                emit autoThingsAppeared({ descriptor });
-                return;
-            }
-
-            // Xiaomi Button Sensor
-            if (modelIdentifier.contains("lumi.sensor_switch")) {
-                qCDebug(dcZigbee()) << "Xiaomi button sensor added";
-
-                qCDebug(dcZigbee()) << "Output cluster:";
-                foreach (ZigbeeCluster *cluster, node->outputClusters()) {
-                    qCDebug(dcZigbee()) << "    " << cluster;
-                }
-
-                qCDebug(dcZigbee()) << "Input cluster:";
-                foreach (ZigbeeCluster *cluster, node->inputClusters()) {
-                    qCDebug(dcZigbee()) << "    " << cluster;
-                }
-
-                ThingDescriptor descriptor(xiaomiButtonSensorThingClassId);
-                descriptor.setParentId(parentThing->id());
-                descriptor.setTitle(tr("Xiaomi button"));
-
-                ParamList params;
-                params.append(Param(xiaomiButtonSensorThingIeeeAddressParamTypeId, node->extendedAddress().toString()));
-                descriptor.setParams(params);
-
-                emit autoThingsAppeared({ descriptor });
-                return;
-            }
-
-            // Xiaomi Motion Sensor
-            if (modelIdentifier.contains("lumi.sensor_motion")) {
-                qCDebug(dcZigbee()) << "Xiaomi motion sensor added";
-
-                qCDebug(dcZigbee()) << "Output cluster:";
-                foreach (ZigbeeCluster *cluster, node->outputClusters()) {
-                    qCDebug(dcZigbee()) << "    " << cluster;
-                }
-
-                qCDebug(dcZigbee()) << "Input cluster:";
-                foreach (ZigbeeCluster *cluster, node->inputClusters()) {
-                    qCDebug(dcZigbee()) << "    " << cluster;
-                }
-
-                ThingDescriptor descriptor(xiaomiMotionSensorThingClassId);
-                descriptor.setParentId(parentThing->id());
-                descriptor.setTitle(tr("Xiaomi motion sensor"));
+    QString modelIdentifier = QString::fromUtf8(node.attribute(Zigbee::ClusterIdBasic, Zigbee::ClusterAttributeBasicModelIdentifier));
+    const ZigbeeDeviceDefinition *definition = m_deviceDefinitions.findDefinition(modelIdentifier);
+    if (!definition) {
+        // If nothing recognized this device, create the generic node device
+        //createGenericNodeDeviceForNode(parentDevice, node);
+        return false;
+    }
 
-                ParamList params;
-                params.append(Param(xiaomiMotionSensorThingIeeeAddressParamTypeId, node->extendedAddress().toString()));
-                descriptor.setParams(params);
+    m_eventLog.record(ZigbeeEventLog::NodeClassified, node.ieeeAddress, node.outputClusters.count());
 
-                emit autoThingsAppeared({ descriptor });
-                return;
-            }
-        }
-    }
+    *descriptor = ThingDescriptor(definition->thingClassId);
+    descriptor->setParentId(parentThing->id());
+    descriptor->setTitle(tr(definition->title));
 
-    // If nothing recognized this device, create the generic node device
-    //createGenericNodeDeviceForNode(parentDevice, node);
+    ParamList params;
+    params.append(Param(definition->ieeeAddressParamTypeId, ZigbeeAddress(node.ieeeAddress).toString()));
+    descriptor->setParams(params);
+    return true;
 }
 
-void IntegrationPluginZigbee::createGenericNodeThingForNode(Thing *parentThing, ZigbeeNode *node)
+void IntegrationPluginZigbee::createGenericNodeThingForNode(Thing *parentThing, const ZigbeeNodeInfo &node)
 {
     ThingDescriptor descriptor;
     descriptor.setParentId(parentThing->id());
 
-    if (node->shortAddress() == 0) {
+    if (node.shortAddress == 0) {
         descriptor.setTitle("Zigbee node (coordinator)");
     } else {
         descriptor.setTitle("Zigbee node");
     }
 
     ParamList params;
-    params.append(Param(zigbeeNodeThingIeeeAddressParamTypeId, node->extendedAddress().toString()));
-    params.append(Param(zigbeeNodeThingNwkAddressParamTypeId, QVariant::fromValue(node->shortAddress())));
+    params.append(Param(zigbeeNodeThingIeeeAddressParamTypeId, ZigbeeAddress(node.ieeeAddress).toString()));
+    params.append(Param(zigbeeNodeThingNwkAddressParamTypeId, QVariant::fromValue(node.shortAddress)));
     descriptor.setParams(params);
 
     emit autoThingsAppeared({ descriptor });
@@ -496,8 +429,8 @@ void IntegrationPluginZigbee::createGenericNodeThingForNode(Thing *parentThing,
 
 void IntegrationPluginZigbee::onZigbeeControllerStateChanged(ZigbeeNetwork::State state)
 {
-    ZigbeeNetworkManager *zigbeeNetworkManager = static_cast<ZigbeeNetworkManager *>(sender());
-    Thing *thing = m_zigbeeControllers.key(zigbeeNetworkManager);
+    ZigbeeNetworkThread *zigbeeNetwork = static_cast<ZigbeeNetworkThread *>(sender());
+    Thing *thing = m_zigbeeControllers.thing(zigbeeNetwork);
     if (!thing) return;
 
     qCDebug(dcZigbee()) << "Controller state changed" << state << thing;
@@ -510,21 +443,33 @@ void IntegrationPluginZigbee::onZigbeeControllerStateChanged(ZigbeeNetwork::Stat
         break;
     case ZigbeeNetwork::StateRunning:
         thing->setStateValue(zigbeeControllerConnectedStateTypeId, true);
-        thing->setStateValue(zigbeeControllerVersionStateTypeId, zigbeeNetworkManager->controllerFirmwareVersion());
-        thing->setStateValue(zigbeeControllerPanIdStateTypeId, zigbeeNetworkManager->extendedPanId());
-        thing->setStateValue(zigbeeControllerChannelStateTypeId, zigbeeNetworkManager->channel());
-        thing->setStateValue(zigbeeControllerPermitJoinStateTypeId, zigbeeNetworkManager->permitJoining());
-        thing->setStateValue(zigbeeControllerIeeeAddressStateTypeId, zigbeeNetworkManager->coordinatorNode()->extendedAddress().toString());
-
-        // Initalize nodes
-        foreach (ZigbeeNode *node, zigbeeNetworkManager->nodes()) {
-            Thing *thing = findNodeThing(node);
-            if (thing) {
-                qCDebug(dcZigbee()) << "Devices for" << node << "already created." << thing;
-                break;
+        thing->setStateValue(zigbeeControllerVersionStateTypeId, zigbeeNetwork->networkInfo().firmwareVersion);
+        thing->setStateValue(zigbeeControllerPanIdStateTypeId, zigbeeNetwork->networkInfo().extendedPanId);
+        thing->setStateValue(zigbeeControllerChannelStateTypeId, zigbeeNetwork->networkInfo().channel);
+        thing->setStateValue(zigbeeControllerPermitJoinStateTypeId, zigbeeNetwork->networkInfo().permitJoining);
+        thing->setStateValue(zigbeeControllerIeeeAddressStateTypeId, ZigbeeAddress(zigbeeNetwork->networkInfo().coordinatorIeeeAddress).toString());
+
+        completePendingSetups(zigbeeNetwork);
+
+        // Classify all nodes first and adopt the new ones in one batch
+        ThingDescriptors descriptors;
+        foreach (const ZigbeeNodeInfo &node, zigbeeNetwork->nodes()) {
+            Thing *nodeThing = findNodeThing(node.ieeeAddress);
+            if (nodeThing) {
+                qCDebug(dcZigbee()) << "Device for" << ZigbeeAddress(node.ieeeAddress).toString() << "already created." << nodeThing;
+                m_attributeRouter->updateNode(node);
+                continue;
             }
 
-            createThingForNode(thing, node);
+            ThingDescriptor descriptor;
+            if (createThingDescriptor(thing, node, &descriptor)) {
+                descriptors.append(descriptor);
+            }
+        }
+
+        if (!descriptors.isEmpty()) {
+            qCDebug(dcZigbee()) << "Adopting" << descriptors.count() << "new nodes";
+            emit autoThingsAppeared(descriptors);
         }
 
         break;
@@ -540,144 +485,106 @@ void IntegrationPluginZigbee::onZigbeeControllerStateChanged(ZigbeeNetwork::Stat
 
 void IntegrationPluginZigbee::onZigbeeControllerChannelChanged(uint channel)
 {
-    ZigbeeNetworkManager *zigbeeNetworkManager = static_cast<ZigbeeNetworkManager *>(sender());
-    Thing *thing = m_zigbeeControllers.key(zigbeeNetworkManager);
+    ZigbeeNetworkThread *zigbeeNetwork = static_cast<ZigbeeNetworkThread *>(sender());
+    Thing *thing = m_zigbeeControllers.thing(zigbeeNetwork);
+    if (!thing) return;
+
     qCDebug(dcZigbee()) << "Zigbee channel changed" << channel << thing;
     thing->setStateValue(zigbeeControllerChannelStateTypeId, channel);
 }
 
 void IntegrationPluginZigbee::onZigbeeControllerPanIdChanged(quint64 extendedPanId)
 {
-    ZigbeeNetworkManager *zigbeeNetworkManager = static_cast<ZigbeeNetworkManager *>(sender());
-    Thing *thing = m_zigbeeControllers.key(zigbeeNetworkManager);
+    ZigbeeNetworkThread *zigbeeNetwork = static_cast<ZigbeeNetworkThread *>(sender());
+    Thing *thing = m_zigbeeControllers.thing(zigbeeNetwork);
+    if (!thing) return;
+
     qCDebug(dcZigbee()) << "Zigbee extended PAN id changed" << extendedPanId << thing;
     thing->setStateValue(zigbeeControllerPanIdStateTypeId, extendedPanId);
 }
 
 void IntegrationPluginZigbee::onZigbeeControllerPermitJoiningChanged(bool permitJoining)
 {
-    ZigbeeNetworkManager *zigbeeNetworkManager = static_cast<ZigbeeNetworkManager *>(sender());
-    Thing *thing = m_zigbeeControllers.key(zigbeeNetworkManager);
+    ZigbeeNetworkThread *zigbeeNetwork = static_cast<ZigbeeNetworkThread *>(sender());
+    Thing *thing = m_zigbeeControllers.thing(zigbeeNetwork);
+    if (!thing) return;
+
     qCDebug(dcZigbee()) << thing << "permit joining changed" << permitJoining;
     thing->setStateValue(zigbeeControllerPermitJoinStateTypeId, permitJoining);
 }
 
-void IntegrationPluginZigbee::onZigbeeControllerNodeAdded(ZigbeeNode *node)
+void IntegrationPluginZigbee::onZigbeeControllerNodeAdded(const ZigbeeNodeInfo &node)
 {
-    ZigbeeNetworkManager *zigbeeNetworkManager = static_cast<ZigbeeNetworkManager *>(sender());
-    Thing *thing = m_zigbeeControllers.key(zigbeeNetworkManager);
-    qCDebug(dcZigbee()) <<  thing << "node added" << thing << node;
+    ZigbeeNetworkThread *zigbeeNetwork = static_cast<ZigbeeNetworkThread *>(sender());
+    Thing *thing = m_zigbeeControllers.thing(zigbeeNetwork);
+    if (!thing) return;
 
-    if (findNodeThing(node)) {
-        qCDebug(dcZigbee()) << "Device for" << node << "already created." << thing;
+    QString ieeeAddress = ZigbeeAddress(node.ieeeAddress).toString();
+    qCDebug(dcZigbee()) <<  thing << "node added" << ieeeAddress;
+
+    ThingSetupInfo *info = m_setupQueue->take(node.ieeeAddress);
+    if (info) {
+        qCDebug(dcZigbee()) << "Continue setup of" << info->thing()->name() << "for" << ieeeAddress;
+        m_thingHandlers.value(info->thing()->thingClassId())->setupThing(info);
         return;
     }
 
-    createThingForNode(thing, node);
-}
-
-void IntegrationPluginZigbee::onZigbeeControllerNodeRemoved(ZigbeeNode *node)
-{
-    ZigbeeNetworkManager *zigbeeNetworkManager = static_cast<ZigbeeNetworkManager *>(sender());
-    Thing *thing = m_zigbeeControllers.key(zigbeeNetworkManager);
-    qCDebug(dcZigbee()) << thing << "node removed" << node;
-    Thing * nodeThing = findNodeThing(node);
-    if (!nodeThing) {
-        qCWarning(dcZigbee()) << "There is no nymea device for this node" << node;
+    if (findNodeThing(node.ieeeAddress)) {
+        qCDebug(dcZigbee()) << "Device for" << ieeeAddress << "already created." << thing;
+        m_attributeRouter->updateNode(node);
         return;
     }
 
-    emit autoThingDisappeared(nodeThing->id());
-}
-
-void IntegrationPluginZigbee::onXiaomiTemperatureSensorConnectedChanged(bool connected)
-{
-    XiaomiTemperatureSensor *sensor = static_cast<XiaomiTemperatureSensor *>(sender());
-    Thing *thing = m_xiaomiTemperatureSensors.key(sensor);
-    thing->setStateValue(xiaomiTemperatureHumidityConnectedStateTypeId, connected);
-}
-
-void IntegrationPluginZigbee::onXiaomiTemperatureSensorTemperatureChanged(double temperature)
-{
-    XiaomiTemperatureSensor *sensor = static_cast<XiaomiTemperatureSensor *>(sender());
-    Thing *thing = m_xiaomiTemperatureSensors.key(sensor);
-    thing->setStateValue(xiaomiTemperatureHumidityTemperatureStateTypeId, temperature);
-    qCDebug(dcZigbee()) << thing << "temperature changed" << temperature << "°C";
-}
-
-void IntegrationPluginZigbee::onXiaomiTemperatureSensorHumidityChanged(double humidity)
-{
-    XiaomiTemperatureSensor *sensor = static_cast<XiaomiTemperatureSensor *>(sender());
-    Thing *thing = m_xiaomiTemperatureSensors.key(sensor);
-    thing->setStateValue(xiaomiTemperatureHumidityHumidityStateTypeId, humidity);
-    qCDebug(dcZigbee()) << thing << "humidity changed" << humidity << "%";
-}
-
-void IntegrationPluginZigbee::onXiaomiMagnetSensorConnectedChanged(bool connected)
-{
-    XiaomiMagnetSensor *sensor = static_cast<XiaomiMagnetSensor *>(sender());
-    Thing *thing = m_xiaomiMagnetSensors.key(sensor);
-    thing->setStateValue(xiaomiMagnetSensorConnectedStateTypeId, connected);
+    ThingDescriptor descriptor;
+    if (createThingDescriptor(thing, node, &descriptor)) {
+        emit autoThingsAppeared({ descriptor });
+    }
 }
 
-void IntegrationPluginZigbee::onXiaomiMagnetSensorClosedChanged(bool closed)
+void IntegrationPluginZigbee::onZigbeeControllerNodeRemoved(quint64 ieeeAddress)
 {
-    XiaomiMagnetSensor *sensor = static_cast<XiaomiMagnetSensor *>(sender());
-    Thing *device = m_xiaomiMagnetSensors.key(sensor);
-    device->setStateValue(xiaomiMagnetSensorClosedStateTypeId, closed);
-    qCDebug(dcZigbee()) << device << (closed ? "closed" : "opened");
-}
+    ZigbeeNetworkThread *zigbeeNetwork = static_cast<ZigbeeNetworkThread *>(sender());
+    Thing *thing = m_zigbeeControllers.thing(zigbeeNetwork);
+    if (!thing) return;
 
-void IntegrationPluginZigbee::onXiaomiButtonSensorConnectedChanged(bool connected)
-{
-    XiaomiButtonSensor *sensor = static_cast<XiaomiButtonSensor *>(sender());
-    Thing *thing = m_xiaomiButtonSensors.key(sensor);
-    thing->setStateValue(xiaomiButtonSensorConnectedStateTypeId, connected);
-}
+    qCDebug(dcZigbee()) << thing << "node removed" << ZigbeeAddress(ieeeAddress).toString();
+    m_snapshot->removeNode(ieeeAddress);
 
-void IntegrationPluginZigbee::onXiaomiButtonSensorPressedChanged(bool pressed)
-{
-    XiaomiButtonSensor *sensor = static_cast<XiaomiButtonSensor *>(sender());
-    Thing *thing = m_xiaomiButtonSensors.key(sensor);
-    //device->setStateValue(xiaomiButtonSensorPressedStateTypeId, pressed);
-    qCDebug(dcZigbee()) << thing << "Button" << (pressed ? "pressed" : "released");
-}
+    Thing * nodeThing = findNodeThing(ieeeAddress);
+    if (!nodeThing) {
+        qCWarning(dcZigbee()) << "There is no nymea device for this node" << ZigbeeAddress(ieeeAddress).toString();
+        return;
+    }
 
-void IntegrationPluginZigbee::onXiaomiButtonSensorPressed()
-{
-    XiaomiButtonSensor *sensor = static_cast<XiaomiButtonSensor *>(sender());
-    Thing *thing = m_xiaomiButtonSensors.key(sensor);
-    emitEvent(Event(xiaomiButtonSensorPressedEventTypeId, thing->id()));
-    qCDebug(dcZigbee()) << thing << "Button clicked";
+    emit autoThingDisappeared(nodeThing->id());
 }
 
-void IntegrationPluginZigbee::onXiaomiButtonSensorLongPressed()
+void IntegrationPluginZigbee::onStatisticsTimeout()
 {
-    XiaomiButtonSensor *sensor = static_cast<XiaomiButtonSensor *>(sender());
-    Thing *thing = m_xiaomiButtonSensors.key(sensor);
-    emitEvent(Event(xiaomiButtonSensorLongPressedEventTypeId, thing->id()));
-    qCDebug(dcZigbee()) << thing << "Button long pressed";
+    foreach (ZigbeeNetworkThread *zigbeeNetwork, m_zigbeeControllers.values()) {
+        zigbeeNetwork->requestStatistics();
+    }
 }
 
-void IntegrationPluginZigbee::onXiaomiMotionSensorConnectedChanged(bool connected)
+void IntegrationPluginZigbee::onZigbeeControllerStatisticsTaken(const ZigbeeNetworkStatistics &statistics)
 {
-    XiaomiMotionSensor *sensor = static_cast<XiaomiMotionSensor *>(sender());
-    Thing *thing = m_xiaomiMotionSensors.key(sensor);
-    thing->setStateValue(xiaomiMotionSensorConnectedStateTypeId, connected);
-}
+    ZigbeeNetworkThread *zigbeeNetwork = static_cast<ZigbeeNetworkThread *>(sender());
+    Thing *thing = m_zigbeeControllers.thing(zigbeeNetwork);
+    if (!thing) return;
 
-void IntegrationPluginZigbee::onXiaomiMotionSensorPresentChanged(bool present)
-{
-    XiaomiMotionSensor *sensor = static_cast<XiaomiMotionSensor *>(sender());
-    Thing *thing = m_xiaomiMotionSensors.key(sensor);
-    thing->setStateValue(xiaomiMotionSensorIsPresentStateTypeId, present);
-    qCDebug(dcZigbee()) << thing << "present changed" << present;
-}
+    // The sensors of all networks share their handlers
+    quint64 suppressedReports = 0;
+    foreach (ZigbeeThingHandler *handler, m_thingHandlers) {
+        suppressedReports += handler->suppressedReportCount();
+    }
 
-void IntegrationPluginZigbee::onXiaomiMotionSensorMotionDetected()
-{
-    XiaomiMotionSensor *sensor = static_cast<XiaomiMotionSensor *>(sender());
-    Thing *thing = m_xiaomiMotionSensors.key(sensor);
-    thing->setStateValue(xiaomiMotionSensorLastSeenTimeStateTypeId, QDateTime::currentDateTimeUtc().toTime_t());
-    qCDebug(dcZigbee()) << thing << "motion detected" << QDateTime::currentDateTimeUtc().toTime_t();
+    thing->setStateValue(zigbeeControllerReportRateStateTypeId, qRound(statistics.reportRate * 10) / 10.0);
+    thing->setStateValue(zigbeeControllerReportLatencyMedianStateTypeId, statistics.reportLatencyMedian);
+    thing->setStateValue(zigbeeControllerReportLatency95StateTypeId, statistics.reportLatency95);
+    thing->setStateValue(zigbeeControllerCriticalReportLatency95StateTypeId, statistics.criticalReportLatency95);
+    thing->setStateValue(zigbeeControllerDroppedReportsStateTypeId, statistics.droppedReports);
+    thing->setStateValue(zigbeeControllerPendingCommandsStateTypeId, statistics.pendingCommands);
+    thing->setStateValue(zigbeeControllerSuppressedReportsStateTypeId, suppressedReports);
+    thing->setStateValue(zigbeeControllerCommandWaitMedianStateTypeId, statistics.commandWaitMedian);
+    thing->setStateValue(zigbeeControllerCommandWait95StateTypeId, statistics.commandWait95);
 }
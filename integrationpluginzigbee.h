@@ -32,13 +32,20 @@
 #ifndef DEVICEPLUGINZIGBEE_H
 #define DEVICEPLUGINZIGBEE_H
 
-#include <integrations/integrationplugin.h>
-#include "zigbeenetworkmanager.h"
+#include <QTimer>
 
-#include "xiaomi/xiaomibuttonsensor.h"
-#include "xiaomi/xiaomimotionsensor.h"
-#include "xiaomi/xiaomimagnetsensor.h"
-#include "xiaomi/xiaomitemperaturesensor.h"
+#include <integrations/integrationplugin.h>
+#include "zigbeeaddress.h"
+
+#include "thingregistry.h"
+#include "zigbeethinghandler.h"
+#include "zigbeeeventlog.h"
+#include "zigbeetimerwheel.h"
+#include "zigbeenetworkthread.h"
+#include "zigbeenodesnapshot.h"
+#include "zigbeesetupqueue.h"
+#include "zigbeeattributerouter.h"
+#include "zigbeedevicedefinitions.h"
 
 class IntegrationPluginZigbee: public IntegrationPlugin
 {
@@ -59,48 +66,46 @@ public:
     void setupThing(ThingSetupInfo *info) override;
     void executeAction(ThingActionInfo *info) override;
 
+    ZigbeeNetworkThread *findParentController(Thing *thing) const;
+    Thing *findNodeThing(quint64 ieeeAddress);
+    // Classifies the node, false if it is not known (yet)
+    bool createThingDescriptor(Thing *parentThing, const ZigbeeNodeInfo &node, ThingDescriptor *descriptor);
+    ZigbeeAttributeRouter *attributeRouter() const;
+    ZigbeeTimerWheel *timerWheel() const;
+    ZigbeeEventLog *eventLog();
+
 private:
-    QHash<Thing *, ZigbeeNetworkManager *> m_zigbeeControllers;
-    QHash<Thing *, XiaomiTemperatureSensor *> m_xiaomiTemperatureSensors;
-    QHash<Thing *, XiaomiMagnetSensor *> m_xiaomiMagnetSensors;
-    QHash<Thing *, XiaomiButtonSensor *> m_xiaomiButtonSensors;
-    QHash<Thing *, XiaomiMotionSensor *> m_xiaomiMotionSensors;
+    ZigbeeAttributeRouter *m_attributeRouter = nullptr;
+    ZigbeeTimerWheel *m_timerWheel = nullptr;
+    ZigbeeNodeSnapshot *m_snapshot = nullptr;
+    ZigbeeSetupQueue *m_setupQueue = nullptr;
+    ZigbeeEventLog m_eventLog;
+    QTimer *m_statisticsTimer = nullptr;
+
+    ThingRegistry<ZigbeeNetworkThread> m_zigbeeControllers;
+    QHash<ThingClassId, ZigbeeThingHandler *> m_thingHandlers;
+
+    // Thing class -> ieee address param, node ieee address -> thing
+    QHash<ThingClassId, ParamTypeId> m_ieeeAddressParamTypeIds;
+    QHash<quint64, Thing *> m_nodeThings;
 
-    ZigbeeNetworkManager *findParentController(Thing *thing) const;
-    ZigbeeNetworkManager *findNodeController(ZigbeeNode *node) const;
+    ZigbeeDeviceDefinitions m_deviceDefinitions;
 
-    Thing *findNodeThing(ZigbeeNode *node);
+    void registerThingHandler(ZigbeeThingHandler *handler);
+    ZigbeeCommandScheduler::Priority commandPriority(const Action &action) const;
 
-    void createThingForNode(Thing *parentThing, ZigbeeNode *node);
-    void createGenericNodeThingForNode(Thing *parentThing, ZigbeeNode *node);
+    void completePendingSetups(ZigbeeNetworkThread *zigbeeNetwork);
+    void createGenericNodeThingForNode(Thing *parentThing, const ZigbeeNodeInfo &node);
 
 private slots:
     void onZigbeeControllerStateChanged(ZigbeeNetwork::State state);
     void onZigbeeControllerChannelChanged(uint channel);
     void onZigbeeControllerPanIdChanged(quint64 extendedPanId);
     void onZigbeeControllerPermitJoiningChanged(bool permitJoining);
-    void onZigbeeControllerNodeAdded(ZigbeeNode *node);
-    void onZigbeeControllerNodeRemoved(ZigbeeNode *node);
-
-    // Xiaomi temperature humidity sensor
-    void onXiaomiTemperatureSensorConnectedChanged(bool connected);
-    void onXiaomiTemperatureSensorTemperatureChanged(double temperature);
-    void onXiaomiTemperatureSensorHumidityChanged(double humidity);
-
-    // Xiaomi magnet sensor
-    void onXiaomiMagnetSensorConnectedChanged(bool connected);
-    void onXiaomiMagnetSensorClosedChanged(bool closed);
-
-    // Xiaomi button sensor
-    void onXiaomiButtonSensorConnectedChanged(bool connected);
-    void onXiaomiButtonSensorPressedChanged(bool pressed);
-    void onXiaomiButtonSensorPressed();
-    void onXiaomiButtonSensorLongPressed();
-
-    // Xiaomi motion sensor
-    void onXiaomiMotionSensorConnectedChanged(bool connected);
-    void onXiaomiMotionSensorPresentChanged(bool present);
-    void onXiaomiMotionSensorMotionDetected();
+    void onZigbeeControllerNodeAdded(const ZigbeeNodeInfo &node);
+    void onZigbeeControllerNodeRemoved(quint64 ieeeAddress);
+    void onStatisticsTimeout();
+    void onZigbeeControllerStatisticsTaken(const ZigbeeNetworkStatistics &statistics);
 };
 
 #endif // DEVICEPLUGINZIGBEE_H
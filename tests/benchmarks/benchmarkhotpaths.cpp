@@ -0,0 +1,559 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <QtTest>
+#include <QThread>
+
+#include <malloc.h>
+
+#include "zigbeetesthost.h"
+#include "zigbeeattributedecoder.h"
+#include "extern-plugininfo.h"
+
+// Sends reports from its own thread, either through a report queue like the network
+// worker does or through a queued signal per report like before the queue existed
+class ReportProducer : public QThread
+{
+    Q_OBJECT
+public:
+    ZigbeeReportQueue *queue = nullptr;
+    bool queuedSignal = false;
+    int count = 0;
+
+signals:
+    void reportsAvailable();
+    void attributeChanged(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data);
+
+protected:
+    void run() override
+    {
+        ZigbeeAttributeReport report;
+        report.ieeeAddress = 0x00158d0002000000;
+        report.clusterId = Zigbee::ClusterIdTemperatureMeasurement;
+        report.length = 2;
+        for (int i = 0; i < count; i++) {
+            qToBigEndian<qint16>(static_cast<qint16>(i), report.data);
+            if (queuedSignal) {
+                emit attributeChanged(report.ieeeAddress, report.clusterId, report.attributeId, QByteArray(report.data, report.length));
+                continue;
+            }
+
+            // Nothing may get lost, the consumer catches up
+            report.timestamp = ZigbeeReportQueue::timestamp();
+            while (!queue->push(report))
+                QThread::yieldCurrentThread();
+
+            if (queue->requestNotification()) {
+                emit reportsAvailable();
+            }
+        }
+    }
+};
+
+// Receives the reports in the main thread like the network facade does
+class ReportConsumer : public QObject
+{
+    Q_OBJECT
+public:
+    ZigbeeReportQueue queue;
+    int received = 0;
+
+public slots:
+    void onReportsAvailable()
+    {
+        queue.clearNotification();
+        ZigbeeAttributeReport reports[16];
+        QByteArray longValues[16];
+        int count = 0;
+        while ((count = queue.pop(reports, 16, longValues)) > 0) {
+            received += count;
+        }
+    }
+
+    void onAttributeChanged(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data)
+    {
+        Q_UNUSED(ieeeAddress)
+        Q_UNUSED(clusterId)
+        Q_UNUSED(attributeId)
+        Q_UNUSED(data)
+        received++;
+    }
+};
+
+// Bytes in use on the heap of the process
+static qint64 heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return static_cast<qint64>(info.uordblks + info.hblkhd);
+#else
+    struct mallinfo info = mallinfo();
+    return static_cast<qint64>(info.uordblks) + info.hblkhd;
+#endif
+}
+
+// Benchmarks of the plugin hot paths with a network of sensors set up like nymead does.
+// The nodes are plain ZigbeeNodeInfo copies restored into the network, the controller sits
+// on /dev/null, so nothing but the plugin code takes part.
+class BenchmarkHotPaths : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int nodeCount = 1000;
+
+    ZigbeeTestHost *m_host = nullptr;
+    Thing *m_controller = nullptr;
+    ZigbeeNetworkThread *m_zigbeeNetwork = nullptr;
+    QList<ZigbeeNodeInfo> m_nodes;
+    QList<Thing *> m_things;
+
+    const ZigbeeNodeInfo &findNode(const QString &modelIdentifier) const;
+
+    // The models the plugin knows, assigned round robin
+    static QList<ZigbeeNodeInfo> createNodes(int count);
+    static bool waitForThings(ZigbeeTestHost *host, int count);
+    Thing *addController(ZigbeeTestHost *host);
+    // Restores the nodes into the network of the controller and creates their things
+    static QList<Thing *> createNodeThings(ZigbeeTestHost *host, Thing *controller, const QList<ZigbeeNodeInfo> &nodes);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void startup_data();
+    void startup();
+    void memoryPerDevice();
+
+    void findNodeThing();
+    void findParentController();
+    void findNetworkNode();
+    void classifyNode();
+    void classifyNodes_data();
+    void classifyNodes();
+
+    void decodeAttribute_data();
+    void decodeAttribute();
+
+    void xiaomiReport_data();
+    void xiaomiReport();
+
+    void reportHandOver_data();
+    void reportHandOver();
+    void reportChain();
+};
+
+const ZigbeeNodeInfo &BenchmarkHotPaths::findNode(const QString &modelIdentifier) const
+{
+    foreach (const ZigbeeNodeInfo &node, m_nodes) {
+        if (node.attribute(Zigbee::ClusterIdBasic, Zigbee::ClusterAttributeBasicModelIdentifier) == modelIdentifier.toUtf8()) {
+            return node;
+        }
+    }
+    return m_nodes.first();
+}
+
+QList<ZigbeeNodeInfo> BenchmarkHotPaths::createNodes(int count)
+{
+    QList<QPair<QString, QList<quint16> > > models = {
+        { "lumi.sensor_ht", { Zigbee::ClusterIdBasic, Zigbee::ClusterIdTemperatureMeasurement, Zigbee::ClusterIdRelativeHumidityMeasurement } },
+        { "lumi.sensor_magnet", { Zigbee::ClusterIdBasic, Zigbee::ClusterIdOnOff } },
+        { "lumi.sensor_switch", { Zigbee::ClusterIdBasic, Zigbee::ClusterIdOnOff } },
+        { "lumi.sensor_motion", { Zigbee::ClusterIdBasic, Zigbee::ClusterIdOccapancySensing } }
+    };
+
+    QList<ZigbeeNodeInfo> nodes;
+    for (int i = 0; i < count; i++) {
+        const QPair<QString, QList<quint16> > &model = models.at(i % models.count());
+        ZigbeeNodeInfo node;
+        node.ieeeAddress = 0x00158d0002000000 + static_cast<quint64>(i);
+        node.shortAddress = static_cast<quint16>(0x1000 + i);
+        node.connected = true;
+        node.inputClusters = model.second;
+        node.outputClusters = model.second;
+        node.attributes.insert(static_cast<quint32>(Zigbee::ClusterIdBasic) << 16 | Zigbee::ClusterAttributeBasicModelIdentifier, model.first.toUtf8());
+        nodes.append(node);
+    }
+    return nodes;
+}
+
+bool BenchmarkHotPaths::waitForThings(ZigbeeTestHost *host, int count)
+{
+    // No sleeping in between like QTRY does, setups finish as soon as the events got processed
+    QElapsedTimer timer;
+    timer.start();
+    while (host->things().count() < count && timer.elapsed() < 30000) {
+        QCoreApplication::processEvents();
+    }
+    return host->things().count() == count;
+}
+
+Thing *BenchmarkHotPaths::addController(ZigbeeTestHost *host)
+{
+    // No coordinator answers on /dev/null, the network never runs
+    Thing *controller = host->createThing(zigbeeControllerThingClassId, { Param(zigbeeControllerThingSerialPortParamTypeId, "/dev/null") });
+    if (!controller)
+        return nullptr;
+
+    host->setupThing(controller);
+    if (!waitForThings(host, host->things().count() + 1))
+        return nullptr;
+
+    return controller;
+}
+
+QList<Thing *> BenchmarkHotPaths::createNodeThings(ZigbeeTestHost *host, Thing *controller, const QList<ZigbeeNodeInfo> &nodes)
+{
+    QHash<QString, QPair<ThingClassId, ParamTypeId> > thingClasses = {
+        { "lumi.sensor_ht", { xiaomiTemperatureHumidityThingClassId, xiaomiTemperatureHumidityThingIeeeAddressParamTypeId } },
+        { "lumi.sensor_magnet", { xiaomiMagnetSensorThingClassId, xiaomiMagnetSensorThingIeeeAddressParamTypeId } },
+        { "lumi.sensor_switch", { xiaomiButtonSensorThingClassId, xiaomiButtonSensorThingIeeeAddressParamTypeId } },
+        { "lumi.sensor_motion", { xiaomiMotionSensorThingClassId, xiaomiMotionSensorThingIeeeAddressParamTypeId } }
+    };
+
+    QList<Thing *> things;
+    foreach (const ZigbeeNodeInfo &node, nodes) {
+        QString modelIdentifier = QString::fromUtf8(node.attribute(Zigbee::ClusterIdBasic, Zigbee::ClusterAttributeBasicModelIdentifier));
+        const QPair<ThingClassId, ParamTypeId> &thingClass = thingClasses[modelIdentifier];
+        Thing *thing = host->createThing(thingClass.first, { Param(thingClass.second, ZigbeeAddress(node.ieeeAddress).toString()) }, controller->id());
+        if (!thing)
+            return QList<Thing *>();
+
+        things.append(thing);
+    }
+
+    // The network of the controller gets resolved through its children
+    ZigbeeNetworkThread *zigbeeNetwork = things.isEmpty() ? nullptr : host->plugin()->findParentController(things.first());
+    if (!zigbeeNetwork)
+        return QList<Thing *>();
+
+    foreach (const ZigbeeNodeInfo &node, nodes) {
+        zigbeeNetwork->restoreNode(node);
+    }
+    return things;
+}
+
+void BenchmarkHotPaths::initTestCase()
+{
+    m_host = new ZigbeeTestHost(this);
+    m_controller = addController(m_host);
+    QVERIFY(m_controller);
+    m_nodes = createNodes(nodeCount);
+    m_things = createNodeThings(m_host, m_controller, m_nodes);
+    QCOMPARE(m_things.count(), nodeCount);
+    m_zigbeeNetwork = m_host->plugin()->findParentController(m_things.first());
+    foreach (Thing *thing, m_things) {
+        m_host->setupThing(thing);
+    }
+    QVERIFY(waitForThings(m_host, nodeCount + 1));
+}
+
+void BenchmarkHotPaths::cleanupTestCase()
+{
+    delete m_host;
+    m_host = nullptr;
+}
+
+void BenchmarkHotPaths::startup_data()
+{
+    QTest::addColumn<int>("nodes");
+
+    QTest::newRow("500 nodes") << 500;
+    QTest::newRow("1000 nodes") << 1000;
+}
+
+void BenchmarkHotPaths::startup()
+{
+    // A restart of nymead with a known network, all node things get set up again
+    QFETCH(int, nodes);
+
+    QList<ZigbeeNodeInfo> nodeInfos = createNodes(nodes);
+    QBENCHMARK_ONCE {
+        ZigbeeTestHost host;
+        Thing *controller = addController(&host);
+        QVERIFY(controller);
+        QList<Thing *> things = createNodeThings(&host, controller, nodeInfos);
+        QCOMPARE(things.count(), nodes);
+        foreach (Thing *thing, things) {
+            host.setupThing(thing);
+        }
+        QVERIFY(waitForThings(&host, nodes + 1));
+    }
+}
+
+void BenchmarkHotPaths::memoryPerDevice()
+{
+    // Heap the plugin takes per set up sensor, the things themselves belong to nymead
+    ZigbeeTestHost host;
+    Thing *controller = addController(&host);
+    QVERIFY(controller);
+    QList<Thing *> things = createNodeThings(&host, controller, createNodes(nodeCount));
+    QCOMPARE(things.count(), nodeCount);
+
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    qint64 heapBefore = heapInUse();
+    foreach (Thing *thing, things) {
+        host.setupThing(thing);
+    }
+    QVERIFY(waitForThings(&host, nodeCount + 1));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    qint64 heapAfter = heapInUse();
+
+    QTest::setBenchmarkResult(static_cast<qreal>(heapAfter - heapBefore) / nodeCount, QTest::BytesAllocated);
+}
+
+void BenchmarkHotPaths::findNodeThing()
+{
+    Thing *thing = nullptr;
+    int i = 0;
+    QBENCHMARK {
+        thing = m_host->plugin()->findNodeThing(m_nodes.at(i++ % nodeCount).ieeeAddress);
+    }
+    QVERIFY(thing);
+}
+
+void BenchmarkHotPaths::findParentController()
+{
+    ZigbeeNetworkThread *zigbeeNetwork = nullptr;
+    int i = 0;
+    QBENCHMARK {
+        zigbeeNetwork = m_host->plugin()->findParentController(m_things.at(i++ % nodeCount));
+    }
+    QCOMPARE(zigbeeNetwork, m_zigbeeNetwork);
+}
+
+void BenchmarkHotPaths::findNetworkNode()
+{
+    // Took the place of findNodeController(), nodes get resolved within the network of the thing
+    const ZigbeeNodeInfo *node = nullptr;
+    int i = 0;
+    QBENCHMARK {
+        node = m_zigbeeNetwork->node(m_nodes.at(i++ % nodeCount).ieeeAddress);
+    }
+    QVERIFY(node);
+}
+
+void BenchmarkHotPaths::classifyNode()
+{
+    // The classification of createThingForNode()
+    ThingDescriptor descriptor;
+    bool classified = false;
+    int i = 0;
+    QBENCHMARK {
+        classified = m_host->plugin()->createThingDescriptor(m_controller, m_nodes.at(i++ % nodeCount), &descriptor);
+    }
+    QVERIFY(classified);
+}
+
+void BenchmarkHotPaths::classifyNodes_data()
+{
+    QTest::addColumn<int>("nodes");
+
+    QTest::newRow("1000 nodes") << 1000;
+    QTest::newRow("10000 nodes") << 10000;
+}
+
+void BenchmarkHotPaths::classifyNodes()
+{
+    // All nodes of a network at once, like the adoption when the network starts
+    QFETCH(int, nodes);
+
+    QList<ZigbeeNodeInfo> nodeInfos = createNodes(nodes);
+    int classified = 0;
+    QBENCHMARK {
+        classified = 0;
+        foreach (const ZigbeeNodeInfo &node, nodeInfos) {
+            ThingDescriptor descriptor;
+            if (m_host->plugin()->createThingDescriptor(m_controller, node, &descriptor)) {
+                classified++;
+            }
+        }
+    }
+    QCOMPARE(classified, nodes);
+}
+
+// Sum of all values in the buffer, the way the sensors decode them now and the way they
+// did before the decoder, copying each value into a QDataStream
+template <typename T>
+static qint64 decodeAll(const QByteArray &buffer)
+{
+    static const int size = sizeof(typename T::RawType);
+    qint64 sum = 0;
+    for (int offset = 0; offset + size <= buffer.size(); offset += size) {
+        sum += ZigbeeAttributeDecoder::decode<T>(buffer.constData() + offset, size);
+    }
+    return sum;
+}
+
+template <typename T>
+static qint64 streamAll(const QByteArray &buffer)
+{
+    static const int size = sizeof(typename T::RawType);
+    qint64 sum = 0;
+    for (int offset = 0; offset + size <= buffer.size(); offset += size) {
+        QByteArray data = buffer.mid(offset, size);
+        QDataStream stream(&data, QIODevice::ReadOnly);
+        typename T::RawType value;
+        stream >> value;
+        sum += value;
+    }
+    return sum;
+}
+
+typedef qint64 (*DecodeFunction)(const QByteArray &);
+
+static DecodeFunction decodeFunction(const QString &decoder)
+{
+    if (decoder == "bool")
+        return &decodeAll<ZclBool>;
+    if (decoder == "uint16")
+        return &decodeAll<ZclUint16>;
+    if (decoder == "int16")
+        return &decodeAll<ZclInt16>;
+    return &streamAll<ZclInt16>;
+}
+
+void BenchmarkHotPaths::decodeAttribute_data()
+{
+    QTest::addColumn<QString>("decoder");
+    QTest::addColumn<int>("size");
+
+    // 10000 values per iteration
+    QTest::newRow("bool") << "bool" << 1;
+    QTest::newRow("uint16") << "uint16" << 2;
+    QTest::newRow("int16") << "int16" << 2;
+    QTest::newRow("int16 QDataStream") << "int16 QDataStream" << 2;
+}
+
+void BenchmarkHotPaths::decodeAttribute()
+{
+    QFETCH(QString, decoder);
+    QFETCH(int, size);
+
+    QByteArray buffer(size * 10000, Qt::Uninitialized);
+    for (int i = 0; i < buffer.size(); i++) {
+        buffer[i] = static_cast<char>(i);
+    }
+
+    DecodeFunction decode = decodeFunction(decoder);
+    qint64 sum = 0;
+    QBENCHMARK {
+        sum = decode(buffer);
+    }
+    QVERIFY(sum != 0);
+}
+
+void BenchmarkHotPaths::xiaomiReport_data()
+{
+    QTest::addColumn<QString>("modelIdentifier");
+    QTest::addColumn<quint16>("clusterId");
+    QTest::addColumn<QByteArray>("value1");
+    QTest::addColumn<QByteArray>("value2");
+
+    QTest::newRow("temperature") << QString("lumi.sensor_ht") << static_cast<quint16>(Zigbee::ClusterIdTemperatureMeasurement) << QByteArray::fromHex("0834") << QByteArray::fromHex("083e");
+    QTest::newRow("humidity") << QString("lumi.sensor_ht") << static_cast<quint16>(Zigbee::ClusterIdRelativeHumidityMeasurement) << QByteArray::fromHex("1388") << QByteArray::fromHex("14b4");
+    QTest::newRow("magnet") << QString("lumi.sensor_magnet") << static_cast<quint16>(Zigbee::ClusterIdOnOff) << QByteArray::fromHex("00") << QByteArray::fromHex("01");
+    QTest::newRow("button") << QString("lumi.sensor_switch") << static_cast<quint16>(Zigbee::ClusterIdOnOff) << QByteArray::fromHex("00") << QByteArray::fromHex("01");
+    QTest::newRow("motion") << QString("lumi.sensor_motion") << static_cast<quint16>(Zigbee::ClusterIdOccapancySensing) << QByteArray::fromHex("01") << QByteArray::fromHex("01");
+}
+
+void BenchmarkHotPaths::xiaomiReport()
+{
+    QFETCH(QString, modelIdentifier);
+    QFETCH(quint16, clusterId);
+    QFETCH(QByteArray, value1);
+    QFETCH(QByteArray, value2);
+
+    // Routing, decoding and the state update of one report, alternating between two values
+    // where the sensor has two
+    const ZigbeeNodeInfo &node = findNode(modelIdentifier);
+    ZigbeeAttributeRouter *attributeRouter = m_host->plugin()->attributeRouter();
+    int i = 0;
+    QBENCHMARK {
+        attributeRouter->onAttributeChanged(node.ieeeAddress, clusterId, 0x0000, (i++ & 1) ? value2 : value1);
+    }
+}
+
+void BenchmarkHotPaths::reportHandOver_data()
+{
+    QTest::addColumn<bool>("queuedSignal");
+
+    QTest::newRow("report queue") << false;
+    QTest::newRow("queued signal") << true;
+}
+
+void BenchmarkHotPaths::reportHandOver()
+{
+    // 10000 reports from another thread into the main thread, nothing but the hand over
+    QFETCH(bool, queuedSignal);
+
+    ReportConsumer consumer;
+    ReportProducer producer;
+    producer.queue = &consumer.queue;
+    producer.queuedSignal = queuedSignal;
+    producer.count = 10000;
+    connect(&producer, &ReportProducer::reportsAvailable, &consumer, &ReportConsumer::onReportsAvailable);
+    connect(&producer, &ReportProducer::attributeChanged, &consumer, &ReportConsumer::onAttributeChanged);
+
+    QBENCHMARK {
+        consumer.received = 0;
+        producer.start();
+        while (consumer.received < producer.count) {
+            QCoreApplication::processEvents();
+        }
+        producer.wait();
+    }
+    QCOMPARE(consumer.received, producer.count);
+}
+
+void BenchmarkHotPaths::reportChain()
+{
+    // From the report queue of the network thread up to the temperature state of the thing
+    const ZigbeeNodeInfo &node = findNode("lumi.sensor_ht");
+    Thing *thing = m_host->plugin()->findNodeThing(node.ieeeAddress);
+    QVERIFY(thing);
+
+    ZigbeeAttributeReport report;
+    report.ieeeAddress = node.ieeeAddress;
+    report.clusterId = Zigbee::ClusterIdTemperatureMeasurement;
+    report.attributeId = 0x0000;
+    report.length = 2;
+    qint16 temperature = 0;
+    QBENCHMARK {
+        temperature = temperature >= 3000 ? 0 : temperature + 50;
+        qToBigEndian<qint16>(temperature, report.data);
+        m_zigbeeNetwork->dispatchReport(report);
+    }
+    QCOMPARE(thing->stateValue(xiaomiTemperatureHumidityTemperatureStateTypeId).toDouble(), temperature / 100.0);
+}
+
+QTEST_MAIN(BenchmarkHotPaths)
+#include "benchmarkhotpaths.moc"
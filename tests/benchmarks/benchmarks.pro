@@ -0,0 +1,6 @@
+include(../common/common.pri)
+
+TARGET = zigbeebenchmarks
+
+SOURCES += \
+    benchmarkhotpaths.cpp
@@ -0,0 +1,34 @@
+# Builds the plugin sources into a test, with the plugin info generated like for the plugin itself
+
+QT += testlib
+QT -= gui
+CONFIG += testcase c++11 link_pkgconfig
+CONFIG -= app_bundle
+PKGCONFIG += nymea
+
+# Test hooks of the plugin sources
+DEFINES += ZIGBEE_TESTING
+# The plugin sources get built once more for the tests, make check fails on any warning
+QMAKE_CXXFLAGS += -Werror
+
+include(../../zigbee.pri)
+
+PLUGIN_JSON = $$PWD/../../integrationpluginzigbee.json
+DEFINES += ZIGBEE_PLUGIN_JSON=\\\"$$PLUGIN_JSON\\\"
+
+plugininfo.target = plugininfo.h
+plugininfo.depends = $$PLUGIN_JSON
+plugininfo.commands = nymea-plugininfocompiler $$PLUGIN_JSON --output plugininfo.h --extern extern-plugininfo.h
+QMAKE_EXTRA_TARGETS += plugininfo
+PRE_TARGETDEPS += plugininfo.h
+QMAKE_CLEAN += plugininfo.h extern-plugininfo.h
+
+INCLUDEPATH += $$OUT_PWD $$PWD
+
+SOURCES += \
+    $$PWD/testthings.cpp \
+    $$PWD/zigbeetesthost.cpp
+
+HEADERS += \
+    $$PWD/testthings.h \
+    $$PWD/zigbeetesthost.h
@@ -0,0 +1,85 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "testthings.h"
+
+#include <type_traits>
+
+// Newer libnymea versions tell the setup whether it is the initial one or a reconfiguration.
+// Templates, so only the constructor of the libnymea in use gets compiled.
+template <typename Info>
+static Info *newSetupInfo(Thing *thing, std::true_type)
+{
+    return new Info(thing, nullptr, true, false);
+}
+
+template <typename Info>
+static Info *newSetupInfo(Thing *thing, std::false_type)
+{
+    return new Info(thing, nullptr);
+}
+
+Thing *ThingManagerImplementation::createThing(const PluginId &pluginId, const ThingClass &thingClass, const ThingId &parentId, const ParamList &params, QObject *parent)
+{
+    Thing *thing = new Thing(pluginId, thingClass, ThingId::createThingId(), parent);
+    thing->setName(thingClass.displayName());
+    thing->setParentId(parentId);
+
+    ParamList thingParams = params;
+    foreach (const ParamType &paramType, thingClass.paramTypes()) {
+        if (!thingParams.hasParam(paramType.id())) {
+            thingParams.append(Param(paramType.id(), paramType.defaultValue()));
+        }
+    }
+    thing->setParams(thingParams);
+
+    ParamList settings;
+    foreach (const ParamType &settingsType, thingClass.settingsTypes()) {
+        settings.append(Param(settingsType.id(), settingsType.defaultValue()));
+    }
+    thing->setSettings(settings);
+
+    States states;
+    foreach (const StateType &stateType, thingClass.stateTypes()) {
+        State state(stateType.id(), thing->id());
+        state.setValue(stateType.defaultValue());
+        states.append(state);
+    }
+    thing->setStates(states);
+    return thing;
+}
+
+ThingSetupInfo *ThingManagerImplementation::createSetupInfo(Thing *thing)
+{
+    // Without a thing manager the setup never times out, the plugin has to finish it
+    typedef std::is_constructible<ThingSetupInfo, Thing *, ThingManager *, bool, bool> HasSetupKind;
+    return newSetupInfo<ThingSetupInfo>(thing, std::integral_constant<bool, HasSetupKind::value>());
+}
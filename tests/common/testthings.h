@@ -0,0 +1,59 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef TESTTHINGS_H
+#define TESTTHINGS_H
+
+#include <integrations/thing.h>
+#include <integrations/thingsetupinfo.h>
+
+// Things and their setup infos get created by the thing manager of nymead only, Thing opens
+// its constructor and setters to the ThingManagerImplementation of nymead. The tests don't
+// link nymead, this one takes its place and creates them for a plugin running inside a test.
+// The states and settings of the thing class start with their default values.
+class ThingManagerImplementation
+{
+public:
+    static Thing *createThing(const PluginId &pluginId, const ThingClass &thingClass, const ThingId &parentId, const ParamList &params, QObject *parent = nullptr);
+    static ThingSetupInfo *createSetupInfo(Thing *thing);
+};
+
+inline Thing *createTestThing(const PluginId &pluginId, const ThingClass &thingClass, const ThingId &parentId, const ParamList &params, QObject *parent = nullptr)
+{
+    return ThingManagerImplementation::createThing(pluginId, thingClass, parentId, params, parent);
+}
+
+inline ThingSetupInfo *createTestSetupInfo(Thing *thing)
+{
+    return ThingManagerImplementation::createSetupInfo(thing);
+}
+
+#endif // TESTTHINGS_H
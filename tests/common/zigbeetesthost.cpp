@@ -0,0 +1,163 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeetesthost.h"
+#include "testthings.h"
+#include "nymeasettings.h"
+#include "extern-plugininfo.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QCoreApplication>
+
+ZigbeeTestHost::ZigbeeTestHost(QObject *parent) :
+    QObject(parent),
+    m_metadata(loadMetadata())
+{
+    // Keep away from the settings of a real nymead and start without any known node
+    QCoreApplication::setOrganizationName("nymea-test");
+    QDir settingsDirectory(NymeaSettings::settingsPath());
+    foreach (const QString &fileName, settingsDirectory.entryList({ "nymea-zigbee*" }, QDir::Files)) {
+        settingsDirectory.remove(fileName);
+    }
+
+    m_plugin = new IntegrationPluginZigbee();
+    m_plugin->init();
+    connect(m_plugin, &IntegrationPlugin::autoThingsAppeared, this, &ZigbeeTestHost::onAutoThingsAppeared);
+    connect(m_plugin, &IntegrationPlugin::autoThingDisappeared, this, &ZigbeeTestHost::onAutoThingDisappeared);
+}
+
+ZigbeeTestHost::~ZigbeeTestHost()
+{
+    // Children first, the controllers go last
+    while (!m_things.isEmpty()) {
+        Thing *thing = m_things.takeLast();
+        m_plugin->thingRemoved(thing);
+        delete thing;
+    }
+
+    delete m_plugin;
+}
+
+IntegrationPluginZigbee *ZigbeeTestHost::plugin() const
+{
+    return m_plugin;
+}
+
+Thing *ZigbeeTestHost::createThing(const ThingClassId &thingClassId, const ParamList &params, const ThingId &parentId)
+{
+    ThingClass thingClass = m_metadata.thingClasses().findById(thingClassId);
+    if (!thingClass.isValid()) {
+        qCWarning(dcZigbee()) << "Unknown thing class" << thingClassId;
+        return nullptr;
+    }
+
+    return createTestThing(m_metadata.pluginId(), thingClass, parentId, params);
+}
+
+void ZigbeeTestHost::setupThing(Thing *thing)
+{
+    ThingSetupInfo *info = createTestSetupInfo(thing);
+    connect(info, &ThingSetupInfo::finished, this, [this, info, thing](){
+        info->deleteLater();
+        if (info->status() != Thing::ThingErrorNoError) {
+            qCWarning(dcZigbee()) << "Setup of" << thing->name() << "failed" << info->status();
+            emit thingSetupFinished(thing, info->status());
+            thing->deleteLater();
+            return;
+        }
+
+        m_things.append(thing);
+        m_plugin->postSetupThing(thing);
+        emit thingSetupFinished(thing, info->status());
+    });
+
+    m_plugin->setupThing(info);
+}
+
+Thing *ZigbeeTestHost::addController(const QString &serialPortName)
+{
+    Thing *thing = createThing(zigbeeControllerThingClassId, { Param(zigbeeControllerThingSerialPortParamTypeId, serialPortName) });
+    setupThing(thing);
+    return thing;
+}
+
+QList<Thing *> ZigbeeTestHost::things() const
+{
+    return m_things;
+}
+
+QList<Thing *> ZigbeeTestHost::things(const ThingClassId &thingClassId) const
+{
+    QList<Thing *> things;
+    foreach (Thing *thing, m_things) {
+        if (thing->thingClassId() == thingClassId) {
+            things.append(thing);
+        }
+    }
+    return things;
+}
+
+QJsonObject ZigbeeTestHost::loadMetadata()
+{
+    QFile file(ZIGBEE_PLUGIN_JSON);
+    if (!file.open(QFile::ReadOnly)) {
+        qCWarning(dcZigbee()) << "Could not open the plugin metadata" << file.fileName();
+        return QJsonObject();
+    }
+
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void ZigbeeTestHost::onAutoThingsAppeared(const ThingDescriptors &thingDescriptors)
+{
+    foreach (const ThingDescriptor &descriptor, thingDescriptors) {
+        Thing *thing = createThing(descriptor.thingClassId(), descriptor.params(), descriptor.parentId());
+        if (!thing)
+            continue;
+
+        thing->setName(descriptor.title());
+        setupThing(thing);
+    }
+}
+
+void ZigbeeTestHost::onAutoThingDisappeared(const ThingId &thingId)
+{
+    foreach (Thing *thing, m_things) {
+        if (thing->id() == thingId) {
+            m_things.removeAll(thing);
+            m_plugin->thingRemoved(thing);
+            delete thing;
+            return;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEETESTHOST_H
+#define ZIGBEETESTHOST_H
+
+#include <QList>
+#include <QObject>
+
+#include <integrations/pluginmetadata.h>
+
+#include "integrationpluginzigbee.h"
+
+// Stands in for the thing manager of nymead. Runs the plugin, sets up the things it
+// discovers automatically and removes the ones which disappear. Settings and snapshot
+// of the plugin live in the configuration of "nymea-test" and start out empty.
+class ZigbeeTestHost : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ZigbeeTestHost(QObject *parent = nullptr);
+    ~ZigbeeTestHost() override;
+
+    IntegrationPluginZigbee *plugin() const;
+
+    // Things get added once their setup finished successfully, failed ones get deleted
+    Thing *createThing(const ThingClassId &thingClassId, const ParamList &params, const ThingId &parentId = ThingId());
+    void setupThing(Thing *thing);
+    Thing *addController(const QString &serialPortName);
+
+    QList<Thing *> things() const;
+    QList<Thing *> things(const ThingClassId &thingClassId) const;
+
+signals:
+    void thingSetupFinished(Thing *thing, Thing::ThingError status);
+
+private:
+    IntegrationPluginZigbee *m_plugin = nullptr;
+    PluginMetadata m_metadata;
+    QList<Thing *> m_things;
+
+    static QJsonObject loadMetadata();
+
+private slots:
+    void onAutoThingsAppeared(const ThingDescriptors &thingDescriptors);
+    void onAutoThingDisappeared(const ThingId &thingId);
+};
+
+#endif // ZIGBEETESTHOST_H
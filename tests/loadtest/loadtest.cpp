@@ -0,0 +1,389 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <QtTest>
+#include <QProcess>
+#include <QTemporaryDir>
+
+#include <algorithm>
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "zigbeetesthost.h"
+#include "zigbeeattributedecoder.h"
+#include "extern-plugininfo.h"
+
+// Counts the reports of the simulator arriving at the network facade and times probes,
+// single reports the simulator sends on request. A probe takes the whole way from the
+// serial port up to the main thread, next to all the other reports.
+class ReportMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReportMonitor(ZigbeeNetworkThread *zigbeeNetwork, QProcess *simulator);
+
+    quint64 receivedReports() const;
+    int lostProbes() const;
+    // Milliseconds
+    double probeLatency(double percentile) const;
+
+    void startProbes(int interval);
+    void stopProbes();
+
+private:
+    QProcess *m_simulator = nullptr;
+    QTimer m_probeTimer;
+    QElapsedTimer m_probeClock;
+    quint16 m_probeSequence = 0;
+    bool m_probePending = false;
+    int m_lostProbes = 0;
+    QVector<double> m_probeLatencies;
+    quint64 m_receivedReports = 0;
+
+private slots:
+    void onAttributeChanged(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data);
+    void sendProbe();
+};
+
+ReportMonitor::ReportMonitor(ZigbeeNetworkThread *zigbeeNetwork, QProcess *simulator) :
+    m_simulator(simulator)
+{
+    connect(zigbeeNetwork, &ZigbeeNetworkThread::attributeChanged, this, &ReportMonitor::onAttributeChanged);
+    connect(&m_probeTimer, &QTimer::timeout, this, &ReportMonitor::sendProbe);
+}
+
+quint64 ReportMonitor::receivedReports() const
+{
+    return m_receivedReports;
+}
+
+int ReportMonitor::lostProbes() const
+{
+    return m_lostProbes + (m_probePending ? 1 : 0);
+}
+
+double ReportMonitor::probeLatency(double percentile) const
+{
+    if (m_probeLatencies.isEmpty())
+        return 0;
+
+    QVector<double> latencies = m_probeLatencies;
+    std::sort(latencies.begin(), latencies.end());
+    return latencies.at(qMin(latencies.count() - 1, static_cast<int>(latencies.count() * percentile)));
+}
+
+void ReportMonitor::startProbes(int interval)
+{
+    m_probeTimer.start(interval);
+}
+
+void ReportMonitor::stopProbes()
+{
+    m_probeTimer.stop();
+}
+
+void ReportMonitor::onAttributeChanged(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data)
+{
+    Q_UNUSED(ieeeAddress)
+
+    // Model identifiers of the announcements and interviews are no load
+    if (clusterId == Zigbee::ClusterIdBasic)
+        return;
+
+    if (clusterId != Zigbee::ClusterIdOnOff || attributeId != 0x4001) {
+        m_receivedReports++;
+        return;
+    }
+
+    if (m_probePending && ZigbeeAttributeDecoder::decode<ZclUint16>(data) == m_probeSequence) {
+        m_probeLatencies.append(m_probeClock.nsecsElapsed() / 1000000.0);
+        m_probePending = false;
+    }
+}
+
+void ReportMonitor::sendProbe()
+{
+    // A probe not back within a second counts as lost
+    if (m_probePending) {
+        if (m_probeClock.elapsed() < 1000)
+            return;
+
+        m_lostProbes++;
+    }
+
+    m_probeSequence++;
+    m_probePending = true;
+    m_probeClock.start();
+    m_simulator->write("probe\n");
+}
+
+// Runs the plugin against the simulated coordinator and measures throughput, latency and
+// CPU usage for a growing number of nodes. Every report the simulator sent has to arrive,
+// at the rate it was sent, and probes have to make it through within the latency bound.
+class LoadTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int measureDuration = 10000;
+    static const int probeInterval = 100;
+    // Milliseconds for 95 % of the probes
+    static const int maxProbeLatency = 50;
+
+    QString m_allModels = "lumi.sensor_ht,lumi.sensor_motion,lumi.sensor_magnet,lumi.sensor_switch";
+    // Temperature reports with a button in between, only the button takes the critical lane
+    QString m_stormModels = "lumi.sensor_ht,lumi.sensor_ht,lumi.sensor_ht,lumi.sensor_ht,lumi.sensor_ht,"
+                            "lumi.sensor_ht,lumi.sensor_ht,lumi.sensor_ht,lumi.sensor_ht,lumi.sensor_switch";
+
+    static qint64 cpuTime();
+    static quint64 stopSimulator(QProcess *simulator);
+    static ZigbeeNetworkStatistics takeStatistics(ZigbeeNetworkThread *zigbeeNetwork);
+
+    ZigbeeNetworkThread *addController(ZigbeeTestHost *host, const ParamList &params, int nodes);
+
+private slots:
+    void reports_data();
+    void reports();
+
+    void replayedStorm();
+    void mainThreadStall();
+};
+
+qint64 LoadTest::cpuTime()
+{
+    // Microseconds of all threads of the process, user and system
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+quint64 LoadTest::stopSimulator(QProcess *simulator)
+{
+    // The simulator answers "stop" with the number of reports it sent
+    simulator->write("stop\n");
+    QRegularExpression sentExpression("^Sent (\\d+) reports");
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 5000) {
+        while (simulator->canReadLine()) {
+            QRegularExpressionMatch match = sentExpression.match(QString::fromUtf8(simulator->readLine()));
+            if (match.hasMatch()) {
+                return match.captured(1).toULongLong();
+            }
+        }
+        simulator->waitForReadyRead(100);
+    }
+    return 0;
+}
+
+ZigbeeNetworkStatistics LoadTest::takeStatistics(ZigbeeNetworkThread *zigbeeNetwork)
+{
+    QSignalSpy spy(zigbeeNetwork, &ZigbeeNetworkThread::statisticsTaken);
+    zigbeeNetwork->requestStatistics();
+    if (!spy.wait(5000))
+        return ZigbeeNetworkStatistics();
+
+    return spy.first().first().value<ZigbeeNetworkStatistics>();
+}
+
+ZigbeeNetworkThread *LoadTest::addController(ZigbeeTestHost *host, const ParamList &params, int nodes)
+{
+    // All nodes have to be classified and set up before the load starts
+    host->setupThing(host->createThing(zigbeeControllerThingClassId, params));
+    QTest::qWaitFor([host, nodes](){ return host->things().count() == nodes + 1; }, 30000 + nodes * 100);
+    if (host->things().count() != nodes + 1)
+        return nullptr;
+
+    ZigbeeNetworkThread *zigbeeNetwork = host->plugin()->findParentController(host->things().last());
+    if (zigbeeNetwork) {
+        takeStatistics(zigbeeNetwork);
+    }
+    return zigbeeNetwork;
+}
+
+void LoadTest::reports_data()
+{
+    QTest::addColumn<int>("nodes");
+    QTest::addColumn<QString>("models");
+    QTest::addColumn<double>("rate");
+
+    QTest::newRow("10 nodes") << 10 << m_allModels << 1.0;
+    QTest::newRow("100 nodes") << 100 << m_allModels << 1.0;
+    // The sustained load attribute routing and the state updates have to keep up with
+    QTest::newRow("200 reports/s") << 200 << m_allModels << 1.0;
+    QTest::newRow("1000 nodes") << 1000 << m_allModels << 1.0;
+    // 1000 reports/s, 100 of them critical
+    QTest::newRow("report storm") << 500 << m_stormModels << 2.0;
+}
+
+void LoadTest::reports()
+{
+    QFETCH(int, nodes);
+    QFETCH(QString, models);
+    QFETCH(double, rate);
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString linkName = directory.filePath("ttyZigbee");
+
+    QProcess simulator;
+    simulator.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    simulator.start(ZIGBEE_SIMULATOR, { "--nodes", QString::number(nodes), "--models", models, "--rate", QString::number(rate), "--link", linkName });
+    QVERIFY(simulator.waitForStarted());
+    QTRY_VERIFY(QFile::exists(linkName));
+
+    ZigbeeTestHost host;
+    ZigbeeNetworkThread *zigbeeNetwork = addController(&host, { Param(zigbeeControllerThingSerialPortParamTypeId, linkName) }, nodes);
+    QVERIFY(zigbeeNetwork);
+
+    ReportMonitor monitor(zigbeeNetwork, &simulator);
+    QElapsedTimer timer;
+    timer.start();
+    qint64 cpuStart = cpuTime();
+    simulator.write("start\n");
+    monitor.startProbes(probeInterval);
+    QTest::qWait(measureDuration);
+    quint64 measuredReports = monitor.receivedReports();
+    double duration = timer.nsecsElapsed() / 1e9;
+    double cpu = 100.0 * (cpuTime() - cpuStart) / (duration * 1e6);
+    monitor.stopProbes();
+    quint64 sentReports = stopSimulator(&simulator);
+
+    // The reports on their way when the simulator stopped still have to arrive
+    QTRY_COMPARE_WITH_TIMEOUT(monitor.receivedReports(), sentReports, 10000);
+
+    double expectedRate = nodes * rate;
+    double reportRate = measuredReports / duration;
+    qInfo("%s: %.1f of %.1f reports/s, probe latency median %.2f ms, 95%% %.2f ms, %d probes lost, CPU %.1f %%",
+          QTest::currentDataTag(), reportRate, expectedRate, monitor.probeLatency(0.5), monitor.probeLatency(0.95),
+          monitor.lostProbes(), cpu);
+
+    simulator.write("quit\n");
+    if (!simulator.waitForFinished(3000))
+        simulator.kill();
+
+    QVERIFY(sentReports > 0);
+    QVERIFY2(reportRate >= 0.9 * expectedRate, "The plugin falls behind the reports");
+    QCOMPARE(monitor.lostProbes(), 0);
+    QVERIFY2(monitor.probeLatency(0.95) < maxProbeLatency, "Probes take too long");
+}
+
+void LoadTest::replayedStorm()
+{
+    // The report storm captured once and replayed as fast as the plugin reads, so the
+    // critical lane competes with a full bulk lane
+    static const int nodes = 500;
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString linkName = directory.filePath("ttyZigbee");
+    QString captureFileName = directory.filePath("storm.zbcp");
+
+    QProcess simulator;
+    simulator.setProcessChannelMode(QProcess::ForwardedChannels);
+    simulator.start(ZIGBEE_SIMULATOR, { "--nodes", QString::number(nodes), "--models", m_stormModels, "--rate", "2", "--link", linkName });
+    QVERIFY(simulator.waitForStarted());
+    QTRY_VERIFY(QFile::exists(linkName));
+
+    {
+        ZigbeeTestHost host;
+        QVERIFY(addController(&host, { Param(zigbeeControllerThingSerialPortParamTypeId, linkName),
+                                       Param(zigbeeControllerThingCaptureFileParamTypeId, captureFileName) }, nodes));
+        simulator.write("start\n");
+        QTest::qWait(measureDuration);
+        simulator.write("quit\n");
+        if (!simulator.waitForFinished(3000))
+            simulator.kill();
+    }
+
+    ZigbeeTestHost host;
+    ZigbeeNetworkThread *zigbeeNetwork = addController(&host, { Param(zigbeeControllerThingReplayFileParamTypeId, captureFileName),
+                                                                Param(zigbeeControllerThingReplayRealTimeParamTypeId, false) }, nodes);
+    QVERIFY(zigbeeNetwork);
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 cpuStart = cpuTime();
+    QTest::qWait(measureDuration);
+    ZigbeeNetworkStatistics statistics = takeStatistics(zigbeeNetwork);
+    qInfo("replayed report storm: %.1f reports/s, latency median %.2f ms, 95%% %.2f ms, critical 95%% %.2f ms, %u dropped, CPU %.1f %%",
+          statistics.reportRate, statistics.reportLatencyMedian, statistics.reportLatency95, statistics.criticalReportLatency95,
+          statistics.droppedReports, 100.0 * (cpuTime() - cpuStart) / (timer.nsecsElapsed() / 1000));
+
+    QVERIFY(statistics.reportRate > 0);
+    QVERIFY2(statistics.criticalReportLatency95 < maxProbeLatency, "Critical reports wait too long behind the bulk lane");
+}
+
+void LoadTest::mainThreadStall()
+{
+    // The serial port lives in the network thread, reports keep getting read and queued
+    // while the main thread is blocked and get dispatched once it is back. Both lanes
+    // have room for the reports of the stall.
+    static const int nodes = 100;
+    static const int stallDuration = 2000;
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString linkName = directory.filePath("ttyZigbee");
+
+    QProcess simulator;
+    simulator.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    simulator.start(ZIGBEE_SIMULATOR, { "--nodes", QString::number(nodes), "--models", m_allModels, "--rate", "1", "--link", linkName });
+    QVERIFY(simulator.waitForStarted());
+    QTRY_VERIFY(QFile::exists(linkName));
+
+    ZigbeeTestHost host;
+    ZigbeeNetworkThread *zigbeeNetwork = addController(&host, { Param(zigbeeControllerThingSerialPortParamTypeId, linkName) }, nodes);
+    QVERIFY(zigbeeNetwork);
+
+    ReportMonitor monitor(zigbeeNetwork, &simulator);
+    simulator.write("start\n");
+    QTest::qWait(1000);
+    QThread::msleep(stallDuration);
+    QTest::qWait(1000);
+    quint64 sentReports = stopSimulator(&simulator);
+
+    QTRY_COMPARE_WITH_TIMEOUT(monitor.receivedReports(), sentReports, 10000);
+    ZigbeeNetworkStatistics statistics = takeStatistics(zigbeeNetwork);
+    qInfo("main thread stalled for %d ms: %llu of %llu reports, latency 95%% %.2f ms, %u dropped",
+          stallDuration, monitor.receivedReports(), sentReports, statistics.reportLatency95, statistics.droppedReports);
+
+    simulator.write("quit\n");
+    if (!simulator.waitForFinished(3000))
+        simulator.kill();
+
+    QVERIFY(sentReports > 0);
+    QCOMPARE(statistics.droppedReports, 0u);
+}
+
+QTEST_MAIN(LoadTest)
+#include "loadtest.moc"
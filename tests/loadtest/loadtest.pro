@@ -0,0 +1,9 @@
+include(../common/common.pri)
+
+TARGET = zigbeeloadtest
+
+# Built by the simulator subproject
+DEFINES += ZIGBEE_SIMULATOR=\\\"$$OUT_PWD/../simulator/nymea-zigbee-simulator\\\"
+
+SOURCES += \
+    loadtest.cpp
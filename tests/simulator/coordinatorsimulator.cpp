@@ -0,0 +1,608 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "coordinatorsimulator.h"
+
+#include <QFile>
+#include <QtEndian>
+#include <QDataStream>
+#include <QLoggingCategory>
+
+#include <fcntl.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <termios.h>
+
+Q_LOGGING_CATEGORY(dcSimulator, "Simulator")
+
+static const quint64 coordinatorIeeeAddress = 0x00158d0001000000;
+static const quint64 extendedPanId = 0x00158d0001000000;
+static const quint16 panId = 0x1a62;
+static const quint8 channel = 11;
+
+// Messages of the NXP serial protocol the simulator knows about
+enum MessageType : quint16 {
+    MessageTypeGetNetworkState = 0x0009,
+    MessageTypeGetVersion = 0x0010,
+    MessageTypeReset = 0x0011,
+    MessageTypeErasePersistentData = 0x0012,
+    MessageTypeGetPermitJoining = 0x0014,
+    MessageTypeGetDevicesList = 0x0015,
+    MessageTypeStartNetwork = 0x0024,
+    MessageTypeNodeDescriptorRequest = 0x0042,
+    MessageTypeSimpleDescriptorRequest = 0x0043,
+    MessageTypePowerDescriptorRequest = 0x0044,
+    MessageTypeActiveEndpointRequest = 0x0045,
+    MessageTypePermitJoiningRequest = 0x0049,
+    MessageTypeDeviceAnnounce = 0x004D,
+    MessageTypeManagementLqiRequest = 0x004E,
+    MessageTypeReadAttributeRequest = 0x0100,
+    MessageTypeStatus = 0x8000,
+    MessageTypeNonFactoryNewRestart = 0x8006,
+    MessageTypeFactoryNewRestart = 0x8007,
+    MessageTypeNetworkState = 0x8009,
+    MessageTypeVersion = 0x8010,
+    MessageTypePermitJoining = 0x8014,
+    MessageTypeDevicesList = 0x8015,
+    MessageTypeNetworkStarted = 0x8024,
+    MessageTypeNodeDescriptor = 0x8042,
+    MessageTypeSimpleDescriptor = 0x8043,
+    MessageTypePowerDescriptor = 0x8044,
+    MessageTypeActiveEndpoints = 0x8045,
+    MessageTypeManagementLqiResponse = 0x804E,
+    MessageTypeReadAttributeResponse = 0x8100,
+    MessageTypeAttributeReport = 0x8102
+};
+
+// ZCL status and data types used in attribute messages
+static const quint8 statusUnsupportedAttribute = 0x86;
+static const quint8 dataTypeBool = 0x10;
+static const quint8 dataTypeBitmap8 = 0x18;
+static const quint8 dataTypeUint16 = 0x21;
+static const quint8 dataTypeInt16 = 0x29;
+static const quint8 dataTypeCharString = 0x42;
+
+// Neighbor table entries per management LQI response, real devices fit 2 to 3 of them
+static const int neighborsPerResponse = 3;
+
+CoordinatorSimulator::CoordinatorSimulator(QObject *parent) :
+    QObject(parent)
+{
+    m_announceTimer = new QTimer(this);
+    m_announceTimer->setInterval(10);
+    connect(m_announceTimer, &QTimer::timeout, this, &CoordinatorSimulator::announceNext);
+
+    m_reportTimer = new QTimer(this);
+    m_reportTimer->setInterval(10);
+    m_reportTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_reportTimer, &QTimer::timeout, this, &CoordinatorSimulator::sendReports);
+}
+
+CoordinatorSimulator::~CoordinatorSimulator()
+{
+    if (!m_linkName.isEmpty())
+        QFile::remove(m_linkName);
+
+    if (m_slaveFd >= 0)
+        ::close(m_slaveFd);
+
+    if (m_masterFd >= 0)
+        ::close(m_masterFd);
+}
+
+void CoordinatorSimulator::setNodes(int count, const QStringList &modelIdentifiers)
+{
+    m_nodes.resize(count);
+    for (int i = 0; i < count; i++) {
+        m_nodes[i].shortAddress = static_cast<quint16>(0x1000 + i);
+        m_nodes[i].ieeeAddress = 0x00158d0002000000 + static_cast<quint64>(i);
+        m_nodes[i].modelIdentifier = modelIdentifiers.at(i % modelIdentifiers.count());
+    }
+}
+
+void CoordinatorSimulator::setReportRate(double reportRate)
+{
+    m_reportRate = reportRate;
+}
+
+bool CoordinatorSimulator::open(const QString &linkName)
+{
+    m_masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m_masterFd < 0 || grantpt(m_masterFd) != 0 || unlockpt(m_masterFd) != 0) {
+        qCWarning(dcSimulator()) << "Could not create a pseudo terminal" << strerror(errno);
+        return false;
+    }
+
+    fcntl(m_masterFd, F_SETFL, fcntl(m_masterFd, F_GETFL) | O_NONBLOCK);
+    m_portName = QString::fromLocal8Bit(ptsname(m_masterFd));
+
+    // Keep the slave open, otherwise the master hangs up whenever the network manager closes it
+    m_slaveFd = ::open(ptsname(m_masterFd), O_RDWR | O_NOCTTY);
+    if (m_slaveFd < 0) {
+        qCWarning(dcSimulator()) << "Could not open pseudo terminal" << m_portName << strerror(errno);
+        return false;
+    }
+
+    struct termios settings;
+    tcgetattr(m_slaveFd, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(m_slaveFd, TCSANOW, &settings);
+
+    if (!linkName.isEmpty()) {
+        QFile::remove(linkName);
+        if (!QFile::link(m_portName, linkName)) {
+            qCWarning(dcSimulator()) << "Could not link" << linkName << "to" << m_portName;
+            return false;
+        }
+        m_linkName = linkName;
+    }
+
+    m_readNotifier = new QSocketNotifier(m_masterFd, QSocketNotifier::Read, this);
+    connect(m_readNotifier, &QSocketNotifier::activated, this, &CoordinatorSimulator::onMasterReadyRead);
+    m_writeNotifier = new QSocketNotifier(m_masterFd, QSocketNotifier::Write, this);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier, &QSocketNotifier::activated, this, &CoordinatorSimulator::onMasterReadyWrite);
+    return true;
+}
+
+QString CoordinatorSimulator::portName() const
+{
+    return m_portName;
+}
+
+void CoordinatorSimulator::startReports()
+{
+    qCDebug(dcSimulator()) << "Start sending" << m_reportRate << "reports per node and second";
+    m_reportBudget = 0;
+    m_lastReportTick = 0;
+    m_reportClock.start();
+    m_reportTimer->start();
+}
+
+void CoordinatorSimulator::stopReports()
+{
+    m_reportTimer->stop();
+}
+
+quint64 CoordinatorSimulator::sentReports() const
+{
+    return m_sentReports;
+}
+
+bool CoordinatorSimulator::sendProbe()
+{
+    for (int i = 0; i < m_announcedNodes; i++) {
+        const Node &node = m_nodes.at(i);
+        if (!inputClusters(node.modelIdentifier).contains(0x0006))
+            continue;
+
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << ++m_probeSequence;
+        sendAttribute(MessageTypeAttributeReport, node, 0x0006, 0x4001, dataTypeUint16, data);
+        return true;
+    }
+
+    qCWarning(dcSimulator()) << "No announced node with the OnOff cluster to send a probe";
+    return false;
+}
+
+void CoordinatorSimulator::onMasterReadyRead()
+{
+    char buffer[512];
+    ssize_t length = 0;
+    while ((length = ::read(m_masterFd, buffer, sizeof(buffer))) > 0) {
+        m_readBuffer.append(buffer, static_cast<int>(length));
+    }
+
+    // Frames are delimited by start and end byte, both never show up escaped
+    forever {
+        int start = m_readBuffer.indexOf(0x01);
+        if (start < 0) {
+            m_readBuffer.clear();
+            return;
+        }
+
+        int end = m_readBuffer.indexOf(0x03, start);
+        if (end < 0) {
+            m_readBuffer.remove(0, start);
+            return;
+        }
+
+        QByteArray frame;
+        for (int i = start + 1; i < end; i++) {
+            if (m_readBuffer.at(i) == 0x02 && i + 1 < end) {
+                frame.append(static_cast<char>(m_readBuffer.at(++i) ^ 0x10));
+            } else {
+                frame.append(m_readBuffer.at(i));
+            }
+        }
+
+        m_readBuffer.remove(0, end + 1);
+        processFrame(frame);
+    }
+}
+
+void CoordinatorSimulator::onMasterReadyWrite()
+{
+    while (!m_writeBuffer.isEmpty()) {
+        ssize_t written = ::write(m_masterFd, m_writeBuffer.constData(), static_cast<size_t>(m_writeBuffer.size()));
+        if (written <= 0)
+            break;
+
+        m_writeBuffer.remove(0, static_cast<int>(written));
+    }
+
+    m_writeNotifier->setEnabled(!m_writeBuffer.isEmpty());
+}
+
+void CoordinatorSimulator::processFrame(const QByteArray &frame)
+{
+    if (frame.size() < 5) {
+        qCWarning(dcSimulator()) << "Frame too short" << frame.toHex();
+        return;
+    }
+
+    quint16 type = qFromBigEndian<quint16>(frame.constData());
+    quint16 length = qFromBigEndian<quint16>(frame.constData() + 2);
+    QByteArray payload = frame.mid(5);
+    if (payload.size() != length) {
+        qCWarning(dcSimulator()) << "Frame length mismatch" << frame.toHex();
+        return;
+    }
+
+    quint8 checksum = 0;
+    for (int i = 0; i < 4; i++)
+        checksum ^= static_cast<quint8>(frame.at(i));
+    foreach (char byte, payload)
+        checksum ^= static_cast<quint8>(byte);
+
+    if (checksum != static_cast<quint8>(frame.at(4))) {
+        qCWarning(dcSimulator()) << "Frame checksum mismatch" << frame.toHex();
+        return;
+    }
+
+    qCDebug(dcSimulator()) << "<--" << QString::number(type, 16) << payload.toHex();
+    processRequest(type, payload);
+}
+
+void CoordinatorSimulator::processRequest(quint16 type, const QByteArray &payload)
+{
+    m_sequenceNumber++;
+    QDataStream request(payload);
+    QByteArray response;
+    QDataStream stream(&response, QIODevice::WriteOnly);
+
+    switch (type) {
+    case MessageTypeGetVersion:
+        sendStatus(type);
+        stream << static_cast<quint16>(0x0003) << static_cast<quint16>(0x031e);
+        sendMessage(MessageTypeVersion, response);
+        break;
+    case MessageTypeReset:
+        sendStatus(type);
+        // The restart message follows once the firmware is up again
+        QTimer::singleShot(10, this, [this](){
+            if (m_networkRunning) {
+                sendMessage(MessageTypeNonFactoryNewRestart, QByteArray(1, 0x06));
+            } else {
+                sendMessage(MessageTypeFactoryNewRestart, QByteArray(1, 0x00));
+            }
+        });
+        break;
+    case MessageTypeErasePersistentData:
+        m_networkRunning = false;
+        sendStatus(type);
+        break;
+    case MessageTypeGetNetworkState:
+        sendStatus(type);
+        stream << static_cast<quint16>(0x0000) << coordinatorIeeeAddress << panId << extendedPanId << channel;
+        sendMessage(MessageTypeNetworkState, response);
+        break;
+    case MessageTypeStartNetwork:
+        sendStatus(type);
+        stream << static_cast<quint8>(m_networkRunning ? 0 : 1) << static_cast<quint16>(0x0000) << coordinatorIeeeAddress << channel;
+        sendMessage(MessageTypeNetworkStarted, response);
+        m_networkRunning = true;
+        if (m_announcedNodes < m_nodes.count()) {
+            m_announceTimer->start();
+        }
+        break;
+    case MessageTypeGetPermitJoining:
+        sendStatus(type);
+        stream << static_cast<quint8>(m_permitJoining);
+        sendMessage(MessageTypePermitJoining, response);
+        break;
+    case MessageTypePermitJoiningRequest: {
+        quint16 targetAddress = 0; quint8 interval = 0;
+        request >> targetAddress >> interval;
+        m_permitJoining = interval > 0;
+        sendStatus(type);
+        break;
+    }
+    case MessageTypeGetDevicesList:
+        sendStatus(type);
+        for (int i = 0; i < m_announcedNodes; i++) {
+            const Node &node = m_nodes.at(i);
+            stream << static_cast<quint8>(i) << node.shortAddress << node.ieeeAddress << static_cast<quint8>(0) << static_cast<quint8>(0xa0);
+        }
+        sendMessage(MessageTypeDevicesList, response);
+        break;
+    case MessageTypeNodeDescriptorRequest: {
+        quint16 targetAddress = 0;
+        request >> targetAddress;
+        sendStatus(type);
+        // Battery powered end devices of LUMI, the coordinator is mains powered
+        bool coordinator = targetAddress == 0x0000;
+        stream << m_sequenceNumber << static_cast<quint8>(0) << targetAddress << static_cast<quint16>(coordinator ? 0x1037 : 0x115f);
+        stream << static_cast<quint16>(0x0050) << static_cast<quint16>(0x0050) << static_cast<quint16>(coordinator ? 0x0001 : 0x0000);
+        stream << static_cast<quint8>(0) << static_cast<quint8>(coordinator ? 0x8f : 0x80) << static_cast<quint8>(0x7f);
+        stream << static_cast<quint16>(coordinator ? 0x0000 : 0x0002);
+        sendMessage(MessageTypeNodeDescriptor, response);
+        break;
+    }
+    case MessageTypeActiveEndpointRequest: {
+        quint16 targetAddress = 0;
+        request >> targetAddress;
+        sendStatus(type);
+        stream << m_sequenceNumber << static_cast<quint8>(0) << targetAddress << static_cast<quint8>(1) << static_cast<quint8>(1);
+        sendMessage(MessageTypeActiveEndpoints, response);
+        break;
+    }
+    case MessageTypeSimpleDescriptorRequest: {
+        quint16 targetAddress = 0; quint8 endpoint = 0;
+        request >> targetAddress >> endpoint;
+        sendStatus(type);
+        const Node *node = findNode(targetAddress);
+        QString modelIdentifier = node ? node->modelIdentifier : QString();
+        QList<quint16> inputs = inputClusters(modelIdentifier);
+        QList<quint16> outputs = outputClusters(modelIdentifier);
+        stream << m_sequenceNumber << static_cast<quint8>(0) << targetAddress << static_cast<quint8>(8 + 2 * (inputs.count() + outputs.count()));
+        stream << endpoint << static_cast<quint16>(0x0104) << static_cast<quint16>(node ? 0x5f01 : 0x0005) << static_cast<quint8>(0x01);
+        stream << static_cast<quint8>(inputs.count());
+        foreach (quint16 clusterId, inputs)
+            stream << clusterId;
+        stream << static_cast<quint8>(outputs.count());
+        foreach (quint16 clusterId, outputs)
+            stream << clusterId;
+        sendMessage(MessageTypeSimpleDescriptor, response);
+        break;
+    }
+    case MessageTypePowerDescriptorRequest: {
+        quint16 targetAddress = 0;
+        request >> targetAddress;
+        sendStatus(type);
+        stream << m_sequenceNumber << static_cast<quint8>(0) << static_cast<quint16>(targetAddress == 0x0000 ? 0x1000 : 0x4c00);
+        sendMessage(MessageTypePowerDescriptor, response);
+        break;
+    }
+    case MessageTypeManagementLqiRequest: {
+        quint16 targetAddress = 0; quint8 startIndex = 0;
+        request >> targetAddress >> startIndex;
+        sendStatus(type);
+        // The virtual nodes are sleeping end devices, all of them children of the coordinator
+        if (targetAddress != 0x0000) {
+            stream << m_sequenceNumber << static_cast<quint8>(0x84) << static_cast<quint8>(0) << static_cast<quint8>(0) << startIndex;
+            sendMessage(MessageTypeManagementLqiResponse, response);
+            break;
+        }
+
+        int tableEntries = qMin(m_announcedNodes, 0xff);
+        int listCount = qBound(0, tableEntries - startIndex, neighborsPerResponse);
+        stream << m_sequenceNumber << static_cast<quint8>(0) << static_cast<quint8>(tableEntries) << static_cast<quint8>(listCount) << startIndex;
+        for (int i = startIndex; i < startIndex + listCount; i++) {
+            const Node &node = m_nodes.at(i);
+            // End device, child, receiver off when idle
+            stream << node.shortAddress << extendedPanId << node.ieeeAddress << static_cast<quint8>(1) << static_cast<quint8>(0xa0) << static_cast<quint8>(0x12);
+        }
+        sendMessage(MessageTypeManagementLqiResponse, response);
+        break;
+    }
+    case MessageTypeReadAttributeRequest: {
+        quint8 addressMode = 0; quint16 targetAddress = 0; quint8 sourceEndpoint = 0; quint8 destinationEndpoint = 0;
+        quint16 clusterId = 0; quint8 direction = 0; quint8 manufacturerSpecific = 0; quint16 manufacturerId = 0; quint8 count = 0;
+        request >> addressMode >> targetAddress >> sourceEndpoint >> destinationEndpoint >> clusterId >> direction >> manufacturerSpecific >> manufacturerId >> count;
+        sendStatus(type);
+
+        const Node *node = findNode(targetAddress);
+        if (!node)
+            break;
+
+        for (int i = 0; i < count && !request.atEnd(); i++) {
+            quint16 attributeId = 0;
+            request >> attributeId;
+            // Xiaomi sensors know manufacturer and model only
+            if (clusterId == 0x0000 && attributeId == 0x0004) {
+                sendAttribute(MessageTypeReadAttributeResponse, *node, clusterId, attributeId, dataTypeCharString, "LUMI");
+            } else if (clusterId == 0x0000 && attributeId == 0x0005) {
+                sendAttribute(MessageTypeReadAttributeResponse, *node, clusterId, attributeId, dataTypeCharString, node->modelIdentifier.toUtf8());
+            } else {
+                sendAttribute(MessageTypeReadAttributeResponse, *node, clusterId, attributeId, 0, QByteArray());
+            }
+        }
+        break;
+    }
+    default:
+        sendStatus(type);
+        break;
+    }
+}
+
+void CoordinatorSimulator::sendMessage(quint16 type, const QByteArray &payload)
+{
+    qCDebug(dcSimulator()) << "-->" << QString::number(type, 16) << payload.toHex();
+
+    QByteArray message(5, 0);
+    qToBigEndian<quint16>(type, message.data());
+    qToBigEndian<quint16>(static_cast<quint16>(payload.size()), message.data() + 2);
+    message.append(payload);
+
+    quint8 checksum = 0;
+    for (int i = 0; i < message.size(); i++) {
+        if (i != 4) {
+            checksum ^= static_cast<quint8>(message.at(i));
+        }
+    }
+    message[4] = static_cast<char>(checksum);
+
+    m_writeBuffer.append(0x01);
+    foreach (char byte, message) {
+        if (static_cast<quint8>(byte) < 0x10) {
+            m_writeBuffer.append(0x02);
+            m_writeBuffer.append(static_cast<char>(byte ^ 0x10));
+        } else {
+            m_writeBuffer.append(byte);
+        }
+    }
+    m_writeBuffer.append(0x03);
+    onMasterReadyWrite();
+}
+
+void CoordinatorSimulator::sendStatus(quint16 requestType, quint8 status)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << status << m_sequenceNumber << requestType;
+    sendMessage(MessageTypeStatus, payload);
+}
+
+void CoordinatorSimulator::sendAttribute(quint16 type, const Node &node, quint16 clusterId, quint16 attributeId, quint8 dataType, const QByteArray &data)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    quint8 status = dataType == 0 ? statusUnsupportedAttribute : 0;
+    stream << m_sequenceNumber << node.shortAddress << static_cast<quint8>(1) << clusterId << attributeId << status << dataType << static_cast<quint16>(data.size());
+    stream.writeRawData(data.constData(), data.size());
+    sendMessage(type, payload);
+}
+
+void CoordinatorSimulator::sendReport(Node *node)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+
+    // Values change with every report, so nothing gets dropped for being unchanged
+    if (node->modelIdentifier.startsWith("lumi.sensor_ht")) {
+        if (node->nextReport++ % 2 == 0) {
+            node->temperature = node->temperature >= 3000 ? 1500 : node->temperature + 10;
+            stream << node->temperature;
+            sendAttribute(MessageTypeAttributeReport, *node, 0x0402, 0x0000, dataTypeInt16, data);
+        } else {
+            node->humidity = node->humidity >= 9000 ? 2000 : node->humidity + 50;
+            stream << node->humidity;
+            sendAttribute(MessageTypeAttributeReport, *node, 0x0405, 0x0000, dataTypeUint16, data);
+        }
+    } else if (node->modelIdentifier.startsWith("lumi.sensor_motion")) {
+        stream << static_cast<quint8>(1);
+        sendAttribute(MessageTypeAttributeReport, *node, 0x0406, 0x0000, dataTypeBitmap8, data);
+    } else if (node->modelIdentifier.startsWith("lumi.sensor_magnet") || node->modelIdentifier.startsWith("lumi.sensor_switch")) {
+        node->on = !node->on;
+        stream << static_cast<quint8>(node->on);
+        sendAttribute(MessageTypeAttributeReport, *node, 0x0006, 0x0000, dataTypeBool, data);
+    } else {
+        sendAttribute(MessageTypeAttributeReport, *node, 0x0000, 0x0005, dataTypeCharString, node->modelIdentifier.toUtf8());
+    }
+
+    m_sentReports++;
+}
+
+const CoordinatorSimulator::Node *CoordinatorSimulator::findNode(quint16 shortAddress) const
+{
+    int index = shortAddress - 0x1000;
+    if (index < 0 || index >= m_announcedNodes)
+        return nullptr;
+
+    return &m_nodes.at(index);
+}
+
+QList<quint16> CoordinatorSimulator::inputClusters(const QString &modelIdentifier)
+{
+    // Basic and Identify, plus the clusters of the sensor
+    if (modelIdentifier.startsWith("lumi.sensor_ht"))
+        return { 0x0000, 0x0003, 0x0402, 0x0405 };
+
+    if (modelIdentifier.startsWith("lumi.sensor_motion"))
+        return { 0x0000, 0x0003, 0x0400, 0x0406 };
+
+    if (modelIdentifier.startsWith("lumi.sensor_magnet") || modelIdentifier.startsWith("lumi.sensor_switch"))
+        return { 0x0000, 0x0003, 0x0006 };
+
+    return { 0x0000, 0x0003 };
+}
+
+QList<quint16> CoordinatorSimulator::outputClusters(const QString &modelIdentifier)
+{
+    Q_UNUSED(modelIdentifier)
+    // Groups and OTA upgrade
+    return { 0x0000, 0x0004, 0x0019 };
+}
+
+void CoordinatorSimulator::announceNext()
+{
+    if (m_announcedNodes >= m_nodes.count()) {
+        m_announceTimer->stop();
+        return;
+    }
+
+    Node &node = m_nodes[m_announcedNodes++];
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << node.shortAddress << node.ieeeAddress << static_cast<quint8>(0x80);
+    sendMessage(MessageTypeDeviceAnnounce, payload);
+
+    // Xiaomi sensors report their model right after joining
+    sendAttribute(MessageTypeAttributeReport, node, 0x0000, 0x0005, dataTypeCharString, node.modelIdentifier.toUtf8());
+
+    if (m_announcedNodes == m_nodes.count()) {
+        m_announceTimer->stop();
+        qCDebug(dcSimulator()) << "All" << m_nodes.count() << "nodes announced";
+        emit nodesAnnounced();
+    }
+}
+
+void CoordinatorSimulator::sendReports()
+{
+    if (m_announcedNodes == 0)
+        return;
+
+    // Reports are due continuously, timer jitter must not change the rate
+    qint64 elapsed = m_reportClock.nsecsElapsed();
+    m_reportBudget += m_reportRate * m_announcedNodes * (elapsed - m_lastReportTick) / 1e9;
+    m_lastReportTick = elapsed;
+
+    while (m_reportBudget >= 1) {
+        sendReport(&m_nodes[m_nextReportNode]);
+        m_nextReportNode = (m_nextReportNode + 1) % m_announcedNodes;
+        m_reportBudget -= 1;
+    }
+}
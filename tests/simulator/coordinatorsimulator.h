@@ -0,0 +1,132 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef COORDINATORSIMULATOR_H
+#define COORDINATORSIMULATOR_H
+
+#include <QTimer>
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QSocketNotifier>
+
+// Plays the coordinator on a pseudo terminal, speaking the NXP serial protocol the
+// ZigbeeNetworkManager of nymea-zigbee talks. Every request gets a status message and,
+// where the protocol has one, a response. Once the network got started the virtual
+// nodes join one after the other and announce their Basic cluster model identifier,
+// just like Xiaomi sensors do. Reports get sent round robin over all nodes.
+//
+// Frame: 0x01, message type (u16), length (u16), checksum (u8), payload, 0x03. All
+// values are big endian, bytes below 0x10 get escaped as 0x02 followed by byte ^ 0x10.
+class CoordinatorSimulator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CoordinatorSimulator(QObject *parent = nullptr);
+    ~CoordinatorSimulator() override;
+
+    // Model identifiers get assigned round robin, i.e. "lumi.sensor_ht", "lumi.sensor_motion"
+    void setNodes(int count, const QStringList &modelIdentifiers);
+    // Attribute reports per node and second
+    void setReportRate(double reportRate);
+
+    // Creates the pseudo terminal and a symlink to it, if a link name is given
+    bool open(const QString &linkName = QString());
+    QString portName() const;
+
+    void startReports();
+    void stopReports();
+    quint64 sentReports() const;
+
+    // Sends the OnOff OnTime attribute with a new sequence number from the first node with
+    // the OnOff cluster. Probes don't count as reports, they let a test time single reports.
+    bool sendProbe();
+
+signals:
+    void nodesAnnounced();
+
+private:
+    struct Node {
+        quint16 shortAddress = 0;
+        quint64 ieeeAddress = 0;
+        QString modelIdentifier;
+        qint16 temperature = 2100;
+        quint16 humidity = 5000;
+        bool on = false;
+        quint8 nextReport = 0;
+    };
+
+    int m_masterFd = -1;
+    int m_slaveFd = -1;
+    QString m_portName;
+    QString m_linkName;
+    QSocketNotifier *m_readNotifier = nullptr;
+    QSocketNotifier *m_writeNotifier = nullptr;
+    QByteArray m_readBuffer;
+    QByteArray m_writeBuffer;
+
+    quint8 m_sequenceNumber = 0;
+    bool m_networkRunning = false;
+    bool m_permitJoining = false;
+
+    QVector<Node> m_nodes;
+    int m_announcedNodes = 0;
+    QTimer *m_announceTimer = nullptr;
+
+    double m_reportRate = 1;
+    double m_reportBudget = 0;
+    int m_nextReportNode = 0;
+    quint64 m_sentReports = 0;
+    quint16 m_probeSequence = 0;
+    QTimer *m_reportTimer = nullptr;
+    QElapsedTimer m_reportClock;
+    qint64 m_lastReportTick = 0;
+
+    void processFrame(const QByteArray &frame);
+    void processRequest(quint16 type, const QByteArray &payload);
+    void sendMessage(quint16 type, const QByteArray &payload);
+    void sendStatus(quint16 requestType, quint8 status = 0);
+    void sendAttribute(quint16 type, const Node &node, quint16 clusterId, quint16 attributeId, quint8 dataType, const QByteArray &data);
+    void sendReport(Node *node);
+
+    const Node *findNode(quint16 shortAddress) const;
+    static QList<quint16> inputClusters(const QString &modelIdentifier);
+    static QList<quint16> outputClusters(const QString &modelIdentifier);
+
+private slots:
+    void onMasterReadyRead();
+    void onMasterReadyWrite();
+    void announceNext();
+    void sendReports();
+};
+
+#endif // COORDINATORSIMULATOR_H
@@ -0,0 +1,115 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <QFile>
+#include <QTextStream>
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QCommandLineParser>
+
+#include <unistd.h>
+
+#include "coordinatorsimulator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    application.setApplicationName("nymea-zigbee-simulator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulated ZigBee coordinator with virtual nodes on a pseudo terminal.\n"
+                                     "Reports start with --start or once \"start\" is read from stdin, \"stop\" stops them again.\n"
+                                     "\"probe\" sends a single OnOff OnTime report with a new sequence number.");
+    parser.addHelpOption();
+    QCommandLineOption nodesOption({"n", "nodes"}, "Number of virtual nodes.", "count", "10");
+    QCommandLineOption modelsOption({"m", "models"}, "Comma separated Basic cluster model identifiers, assigned round robin.", "models",
+                                    "lumi.sensor_ht,lumi.sensor_motion,lumi.sensor_magnet,lumi.sensor_switch");
+    QCommandLineOption rateOption({"r", "rate"}, "Attribute reports per node and second.", "rate", "1");
+    QCommandLineOption linkOption({"l", "link"}, "Symlink to create for the pseudo terminal.", "path");
+    QCommandLineOption startOption("start", "Start sending reports right away.");
+    parser.addOptions({ nodesOption, modelsOption, rateOption, linkOption, startOption });
+    parser.process(application);
+
+    bool nodesOk = false; bool rateOk = false;
+    int nodes = parser.value(nodesOption).toInt(&nodesOk);
+    double rate = parser.value(rateOption).toDouble(&rateOk);
+    QStringList models = parser.value(modelsOption).split(',', QString::SkipEmptyParts);
+    if (!nodesOk || nodes < 0 || nodes > 0xe000 || !rateOk || rate < 0 || models.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    CoordinatorSimulator simulator;
+    simulator.setNodes(nodes, models);
+    simulator.setReportRate(rate);
+    if (!simulator.open(parser.value(linkOption)))
+        return 1;
+
+    QTextStream out(stdout);
+    out << "Coordinator simulator on " << simulator.portName() << endl;
+
+    QObject::connect(&simulator, &CoordinatorSimulator::nodesAnnounced, [&out, &simulator, nodes](){
+        out << "Announced " << nodes << " nodes on " << simulator.portName() << endl;
+    });
+
+    if (parser.isSet(startOption))
+        simulator.startReports();
+
+    // Commands on stdin, so a test can start the load once the plugin set up all things
+    QByteArray input;
+    QSocketNotifier stdinNotifier(STDIN_FILENO, QSocketNotifier::Read);
+    QObject::connect(&stdinNotifier, &QSocketNotifier::activated, [&](){
+        char buffer[256];
+        ssize_t length = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (length <= 0) {
+            stdinNotifier.setEnabled(false);
+            return;
+        }
+
+        input.append(buffer, static_cast<int>(length));
+        int newline = -1;
+        while ((newline = input.indexOf('\n')) >= 0) {
+            QByteArray command = input.left(newline).trimmed();
+            input.remove(0, newline + 1);
+            if (command == "start") {
+                simulator.startReports();
+            } else if (command == "stop") {
+                simulator.stopReports();
+                out << "Sent " << simulator.sentReports() << " reports" << endl;
+            } else if (command == "probe") {
+                simulator.sendProbe();
+            } else if (command == "quit") {
+                application.quit();
+            }
+        }
+    });
+
+    return application.exec();
+}
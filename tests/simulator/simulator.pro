@@ -0,0 +1,13 @@
+TEMPLATE = app
+TARGET = nymea-zigbee-simulator
+
+QT -= gui
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+SOURCES += \
+    coordinatorsimulator.cpp \
+    main.cpp
+
+HEADERS += \
+    coordinatorsimulator.h
@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+
+# "make check" runs the tests, TESTARGS="-o results.xml,xml" writes the results as XML
+SUBDIRS += \
+    benchmarks \
+    loadtest \
+    simulator
+
+loadtest.depends = simulator
@@ -0,0 +1,90 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef THINGREGISTRY_H
+#define THINGREGISTRY_H
+
+#include <QHash>
+
+#include <integrations/thing.h>
+
+// Keeps a thing, its id and the object handling it resolvable in constant time
+template <typename T>
+class ThingRegistry
+{
+public:
+    void insert(Thing *thing, T *object)
+    {
+        m_objects.insert(thing, object);
+        m_things.insert(object, thing);
+        m_ids.insert(thing->id(), object);
+    }
+
+    T *take(Thing *thing)
+    {
+        T *object = m_objects.take(thing);
+        m_things.remove(object);
+        m_ids.remove(thing->id());
+        return object;
+    }
+
+    bool contains(Thing *thing) const
+    {
+        return m_objects.contains(thing);
+    }
+
+    T *value(Thing *thing) const
+    {
+        return m_objects.value(thing);
+    }
+
+    T *value(const ThingId &thingId) const
+    {
+        return m_ids.value(thingId);
+    }
+
+    Thing *thing(T *object) const
+    {
+        return m_things.value(object);
+    }
+
+    QList<T *> values() const
+    {
+        return m_objects.values();
+    }
+
+private:
+    QHash<Thing *, T *> m_objects;
+    QHash<T *, Thing *> m_things;
+    QHash<ThingId, T *> m_ids;
+};
+
+#endif // THINGREGISTRY_H
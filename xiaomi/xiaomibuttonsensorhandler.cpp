@@ -0,0 +1,96 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "xiaomibuttonsensorhandler.h"
+#include "integrationpluginzigbee.h"
+#include "zigbeetrace.h"
+#include "zigbeeattributedecoder.h"
+#include "extern-plugininfo.h"
+
+XiaomiButtonSensorHandler::XiaomiButtonSensorHandler(IntegrationPluginZigbee *plugin) :
+    ZigbeeSensorHandler(plugin, xiaomiButtonSensorThingClassId, xiaomiButtonSensorThingIeeeAddressParamTypeId, xiaomiButtonSensorConnectedStateTypeId)
+{
+    registerAttribute(Zigbee::ClusterIdOnOff, 0x0000, [this](int deviceId, const QByteArray &data) {
+        onOnOffReport(deviceId, data);
+    }, false);
+}
+
+void XiaomiButtonSensorHandler::resizeDevices(int count)
+{
+    ZigbeeSensorHandler::resizeDevices(count);
+    m_pressed.resize(count);
+    m_longPressedTimers.resize(count);
+}
+
+void XiaomiButtonSensorHandler::resetDevice(int deviceId)
+{
+    ZigbeeSensorHandler::resetDevice(deviceId);
+    m_plugin->timerWheel()->cancel(m_longPressedTimers.at(deviceId));
+    m_longPressedTimers[deviceId] = 0;
+    m_pressed[deviceId] = false;
+}
+
+void XiaomiButtonSensorHandler::onOnOffReport(int deviceId, const QByteArray &data)
+{
+    bool valueOk = false;
+    bool released = ZigbeeAttributeDecoder::decode<ZclBool>(data, &valueOk);
+    if (!valueOk || m_pressed.at(deviceId) == !released)
+        return;
+
+    ZIGBEE_TRACE(HopDecoded);
+
+    Thing *thing = m_things.at(deviceId);
+    ZigbeeEventLog *eventLog = m_plugin->eventLog();
+    ZigbeeTimerWheel *timerWheel = m_plugin->timerWheel();
+    m_pressed[deviceId] = !released;
+    if (m_pressed.at(deviceId)) {
+        eventLog->record(ZigbeeEventLog::ButtonPressed, m_ieeeAddresses.at(deviceId));
+        timerWheel->cancel(m_longPressedTimers.at(deviceId));
+        m_longPressedTimers[deviceId] = timerWheel->start(300, [this, deviceId](){
+            onLongPressedTimeout(deviceId);
+        });
+    } else {
+        eventLog->record(ZigbeeEventLog::ButtonReleased, m_ieeeAddresses.at(deviceId));
+        if (timerWheel->isActive(m_longPressedTimers.at(deviceId))) {
+            timerWheel->cancel(m_longPressedTimers.at(deviceId));
+            emit m_plugin->emitEvent(Event(xiaomiButtonSensorPressedEventTypeId, thing->id()));
+            ZIGBEE_TRACE(HopEventEmitted);
+            eventLog->record(ZigbeeEventLog::ButtonClicked, m_ieeeAddresses.at(deviceId));
+        }
+    }
+}
+
+void XiaomiButtonSensorHandler::onLongPressedTimeout(int deviceId)
+{
+    Thing *thing = m_things.at(deviceId);
+    emit m_plugin->emitEvent(Event(xiaomiButtonSensorLongPressedEventTypeId, thing->id()));
+    m_plugin->eventLog()->record(ZigbeeEventLog::ButtonLongPressed, m_ieeeAddresses.at(deviceId));
+}
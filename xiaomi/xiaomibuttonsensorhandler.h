@@ -28,40 +28,29 @@
 *
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#ifndef XIAOMIMAGNETSENSOR_H
-#define XIAOMIMAGNETSENSOR_H
 
-#include <QObject>
+#ifndef XIAOMIBUTTONSENSORHANDLER_H
+#define XIAOMIBUTTONSENSORHANDLER_H
 
-#include "zigbeenode.h"
+#include "zigbeesensorhandler.h"
+#include "zigbeetimerwheel.h"
 
-class XiaomiMagnetSensor : public QObject
+class XiaomiButtonSensorHandler : public ZigbeeSensorHandler
 {
     Q_OBJECT
 public:
-    explicit XiaomiMagnetSensor(ZigbeeNode *node, QObject *parent = nullptr);
+    explicit XiaomiButtonSensorHandler(IntegrationPluginZigbee *plugin);
 
-    bool connected() const;
-    bool closed() const;
+protected:
+    void resizeDevices(int count) override;
+    void resetDevice(int deviceId) override;
 
 private:
-    ZigbeeNode *m_node = nullptr;
-
-    bool m_connected = false;
-    bool m_closed = false;
-
-    void setConnected(bool connected);
-    void setClosed(bool closed);
-
-signals:
-    void connectedChanged(bool connected);
-    void closedChanged(bool closed);
-
-
-private slots:
-    void onNodeConnectedChanged(bool connected);
-    void onClusterAttributeChanged(ZigbeeCluster *cluster, const ZigbeeClusterAttribute &attribute);
+    QVector<bool> m_pressed;
+    QVector<ZigbeeTimerWheel::TimerId> m_longPressedTimers;
 
+    void onOnOffReport(int deviceId, const QByteArray &data);
+    void onLongPressedTimeout(int deviceId);
 };
 
-#endif // XIAOMIMAGNETSENSOR_H
+#endif // XIAOMIBUTTONSENSORHANDLER_H
@@ -0,0 +1,70 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "xiaomimagnetsensorhandler.h"
+#include "integrationpluginzigbee.h"
+#include "zigbeetrace.h"
+#include "zigbeeattributedecoder.h"
+#include "extern-plugininfo.h"
+
+XiaomiMagnetSensorHandler::XiaomiMagnetSensorHandler(IntegrationPluginZigbee *plugin) :
+    ZigbeeSensorHandler(plugin, xiaomiMagnetSensorThingClassId, xiaomiMagnetSensorThingIeeeAddressParamTypeId, xiaomiMagnetSensorConnectedStateTypeId)
+{
+    registerAttribute(Zigbee::ClusterIdOnOff, 0x0000, [this](int deviceId, const QByteArray &data) {
+        onOnOffReport(deviceId, data);
+    });
+}
+
+void XiaomiMagnetSensorHandler::resizeDevices(int count)
+{
+    ZigbeeSensorHandler::resizeDevices(count);
+    m_closed.resize(count);
+}
+
+void XiaomiMagnetSensorHandler::resetDevice(int deviceId)
+{
+    ZigbeeSensorHandler::resetDevice(deviceId);
+    m_closed[deviceId] = false;
+}
+
+void XiaomiMagnetSensorHandler::onOnOffReport(int deviceId, const QByteArray &data)
+{
+    bool valueOk = false;
+    bool open = ZigbeeAttributeDecoder::decode<ZclBool>(data, &valueOk);
+    if (!valueOk)
+        return;
+
+    ZIGBEE_TRACE(HopDecoded);
+    m_closed[deviceId] = !open;
+    m_things.at(deviceId)->setStateValue(xiaomiMagnetSensorClosedStateTypeId, m_closed.at(deviceId));
+    ZIGBEE_TRACE(HopStateChanged);
+    m_plugin->eventLog()->record(open ? ZigbeeEventLog::MagnetOpened : ZigbeeEventLog::MagnetClosed, m_ieeeAddresses.at(deviceId));
+}
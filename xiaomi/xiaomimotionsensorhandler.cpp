@@ -0,0 +1,96 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "xiaomimotionsensorhandler.h"
+#include "integrationpluginzigbee.h"
+#include "zigbeetrace.h"
+#include "extern-plugininfo.h"
+
+XiaomiMotionSensorHandler::XiaomiMotionSensorHandler(IntegrationPluginZigbee *plugin) :
+    ZigbeeSensorHandler(plugin, xiaomiMotionSensorThingClassId, xiaomiMotionSensorThingIeeeAddressParamTypeId, xiaomiMotionSensorConnectedStateTypeId)
+{
+    // The sensor reports motion on varying attributes of the occupancy cluster, all of them count
+    registerCluster(Zigbee::ClusterIdOccapancySensing, [this](int deviceId, const QByteArray &data) {
+        onOccupancyReport(deviceId, data);
+    });
+}
+
+void XiaomiMotionSensorHandler::postSetupThing(Thing *thing)
+{
+    thing->setStateValue(xiaomiMotionSensorIsPresentStateTypeId, false);
+}
+
+void XiaomiMotionSensorHandler::resizeDevices(int count)
+{
+    ZigbeeSensorHandler::resizeDevices(count);
+    m_present.resize(count);
+    m_presenceTimers.resize(count);
+}
+
+void XiaomiMotionSensorHandler::resetDevice(int deviceId)
+{
+    ZigbeeSensorHandler::resetDevice(deviceId);
+    m_plugin->timerWheel()->cancel(m_presenceTimers.at(deviceId));
+    m_presenceTimers[deviceId] = 0;
+    m_present[deviceId] = false;
+}
+
+void XiaomiMotionSensorHandler::onOccupancyReport(int deviceId, const QByteArray &data)
+{
+    Q_UNUSED(data)
+    ZIGBEE_TRACE(HopDecoded);
+
+    // The presence delay starts with the transition to present, like the sensor itself does
+    if (!m_present.at(deviceId)) {
+        m_presenceTimers[deviceId] = m_plugin->timerWheel()->start(m_presenceDelay * 1000, [this, deviceId](){
+            m_presenceTimers[deviceId] = 0;
+            setPresent(deviceId, false);
+        });
+    }
+
+    setPresent(deviceId, true);
+
+    Thing *thing = m_things.at(deviceId);
+    uint lastSeenTime = static_cast<uint>(m_lastSeen.at(deviceId) / 1000);
+    thing->setStateValue(xiaomiMotionSensorLastSeenTimeStateTypeId, lastSeenTime);
+    m_plugin->eventLog()->record(ZigbeeEventLog::MotionDetected, m_ieeeAddresses.at(deviceId), lastSeenTime);
+}
+
+void XiaomiMotionSensorHandler::setPresent(int deviceId, bool present)
+{
+    if (m_present.at(deviceId) == present)
+        return;
+
+    m_present[deviceId] = present;
+    m_things.at(deviceId)->setStateValue(xiaomiMotionSensorIsPresentStateTypeId, present);
+    ZIGBEE_TRACE(HopStateChanged);
+    m_plugin->eventLog()->record(ZigbeeEventLog::PresenceChanged, m_ieeeAddresses.at(deviceId), present);
+}
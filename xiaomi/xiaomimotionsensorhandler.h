@@ -28,48 +28,34 @@
 *
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#ifndef XIAOMIMOTIONSENSOR_H
-#define XIAOMIMOTIONSENSOR_H
 
-#include <QObject>
-#include <QTimer>
+#ifndef XIAOMIMOTIONSENSORHANDLER_H
+#define XIAOMIMOTIONSENSORHANDLER_H
 
-#include "zigbeenode.h"
+#include "zigbeesensorhandler.h"
+#include "zigbeetimerwheel.h"
 
-class XiaomiMotionSensor : public QObject
+class XiaomiMotionSensorHandler : public ZigbeeSensorHandler
 {
     Q_OBJECT
 public:
-    explicit XiaomiMotionSensor(ZigbeeNode *node, QObject *parent = nullptr);
+    explicit XiaomiMotionSensorHandler(IntegrationPluginZigbee *plugin);
 
-    bool connected() const;
-    bool present() const;
+    void postSetupThing(Thing *thing) override;
 
-    int delay() const;
-    void setDelay(int delay);
+protected:
+    void resizeDevices(int count) override;
+    void resetDevice(int deviceId) override;
 
 private:
-    ZigbeeNode *m_node = nullptr;
-    QTimer *m_delayTimer = nullptr;
+    // Seconds the sensor stays present after the last motion
+    int m_presenceDelay = 60;
 
-    bool m_connected = false;
-    bool m_present = false;
-    int m_delay = 60;
+    QVector<bool> m_present;
+    QVector<ZigbeeTimerWheel::TimerId> m_presenceTimers;
 
-    void setConnected(bool connected);
-    void setPresent(bool present);
-
-signals:
-    void connectedChanged(bool connected);
-    void delayChanged(int delay);
-    void presentChanged(bool present);
-    void motionDetected();
-
-private slots:
-    void onNodeConnectedChanged(bool connected);
-    void onClusterAttributeChanged(ZigbeeCluster *cluster, const ZigbeeClusterAttribute &attribute);
-
-    void onDelayTimerTimeout();
+    void onOccupancyReport(int deviceId, const QByteArray &data);
+    void setPresent(int deviceId, bool present);
 };
 
-#endif // XIAOMIMOTIONSENSOR_H
+#endif // XIAOMIMOTIONSENSORHANDLER_H
@@ -0,0 +1,128 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "xiaomitemperaturesensorhandler.h"
+#include "integrationpluginzigbee.h"
+#include "zigbeetrace.h"
+#include "zigbeeattributedecoder.h"
+#include "extern-plugininfo.h"
+
+XiaomiTemperatureSensorHandler::XiaomiTemperatureSensorHandler(IntegrationPluginZigbee *plugin) :
+    ZigbeeSensorHandler(plugin, xiaomiTemperatureHumidityThingClassId, xiaomiTemperatureHumidityThingIeeeAddressParamTypeId, xiaomiTemperatureHumidityConnectedStateTypeId),
+    m_temperatureFilter(plugin->timerWheel(), [this](int deviceId, double temperature) {
+        m_things.at(deviceId)->setStateValue(xiaomiTemperatureHumidityTemperatureStateTypeId, temperature);
+        ZIGBEE_TRACE(HopStateChanged);
+        m_plugin->eventLog()->record(ZigbeeEventLog::Temperature, m_ieeeAddresses.at(deviceId), temperature);
+    }),
+    m_humidityFilter(plugin->timerWheel(), [this](int deviceId, double humidity) {
+        m_things.at(deviceId)->setStateValue(xiaomiTemperatureHumidityHumidityStateTypeId, humidity);
+        ZIGBEE_TRACE(HopStateChanged);
+        m_plugin->eventLog()->record(ZigbeeEventLog::Humidity, m_ieeeAddresses.at(deviceId), humidity);
+    })
+{
+    registerAttribute(Zigbee::ClusterIdTemperatureMeasurement, 0x0000, [this](int deviceId, const QByteArray &data) {
+        onTemperatureReport(deviceId, data);
+    });
+    registerAttribute(Zigbee::ClusterIdRelativeHumidityMeasurement, 0x0000, [this](int deviceId, const QByteArray &data) {
+        onHumidityReport(deviceId, data);
+    });
+}
+
+void XiaomiTemperatureSensorHandler::resizeDevices(int count)
+{
+    ZigbeeSensorHandler::resizeDevices(count);
+    m_temperature.resize(count);
+    m_humidity.resize(count);
+    m_temperatureFilter.resize(count);
+    m_humidityFilter.resize(count);
+}
+
+void XiaomiTemperatureSensorHandler::resetDevice(int deviceId)
+{
+    ZigbeeSensorHandler::resetDevice(deviceId);
+    m_temperature[deviceId] = 0;
+    m_humidity[deviceId] = 0;
+    m_temperatureFilter.reset(deviceId);
+    m_humidityFilter.reset(deviceId);
+}
+
+void XiaomiTemperatureSensorHandler::setupDevice(int deviceId)
+{
+    Thing *thing = m_things.at(deviceId);
+    applySettings(deviceId);
+
+    disconnect(thing, &Thing::settingChanged, this, nullptr);
+    connect(thing, &Thing::settingChanged, this, [this, thing, deviceId](const ParamTypeId &paramTypeId, const QVariant &value) {
+        Q_UNUSED(paramTypeId)
+        Q_UNUSED(value)
+        if (m_things.at(deviceId) == thing) {
+            applySettings(deviceId);
+        }
+    });
+}
+
+void XiaomiTemperatureSensorHandler::applySettings(int deviceId)
+{
+    Thing *thing = m_things.at(deviceId);
+    int minimumInterval = thing->setting(xiaomiTemperatureHumiditySettingsMinimumReportIntervalParamTypeId).toInt() * 1000;
+
+    m_temperatureFilter.configure(deviceId, thing->setting(xiaomiTemperatureHumiditySettingsTemperatureDeadbandParamTypeId).toDouble(), minimumInterval);
+    m_humidityFilter.configure(deviceId, thing->setting(xiaomiTemperatureHumiditySettingsHumidityDeadbandParamTypeId).toDouble(), minimumInterval);
+}
+
+quint64 XiaomiTemperatureSensorHandler::suppressedReportCount() const
+{
+    return m_temperatureFilter.suppressedCount() + m_humidityFilter.suppressedCount();
+}
+
+void XiaomiTemperatureSensorHandler::onTemperatureReport(int deviceId, const QByteArray &data)
+{
+    bool valueOk = false;
+    qint16 temperatureRaw = ZigbeeAttributeDecoder::decode<ZclInt16>(data, &valueOk);
+    if (!valueOk)
+        return;
+
+    ZIGBEE_TRACE(HopDecoded);
+    m_temperature[deviceId] = temperatureRaw / 100.0;
+    m_temperatureFilter.submit(deviceId, m_temperature.at(deviceId));
+}
+
+void XiaomiTemperatureSensorHandler::onHumidityReport(int deviceId, const QByteArray &data)
+{
+    bool valueOk = false;
+    quint16 humidityRaw = ZigbeeAttributeDecoder::decode<ZclUint16>(data, &valueOk);
+    if (!valueOk)
+        return;
+
+    ZIGBEE_TRACE(HopDecoded);
+    m_humidity[deviceId] = humidityRaw / 100.0;
+    m_humidityFilter.submit(deviceId, m_humidity.at(deviceId));
+}
@@ -28,43 +28,37 @@
 *
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#ifndef XIAOMITEMPERATURESENSOR_H
-#define XIAOMITEMPERATURESENSOR_H
 
-#include <QObject>
+#ifndef XIAOMITEMPERATURESENSORHANDLER_H
+#define XIAOMITEMPERATURESENSORHANDLER_H
 
-#include "zigbeenode.h"
+#include "zigbeesensorhandler.h"
+#include "zigbeereportfilter.h"
 
-class XiaomiTemperatureSensor : public QObject
+class XiaomiTemperatureSensorHandler : public ZigbeeSensorHandler
 {
     Q_OBJECT
 public:
-    explicit XiaomiTemperatureSensor(ZigbeeNode *node, QObject *parent = nullptr);
+    explicit XiaomiTemperatureSensorHandler(IntegrationPluginZigbee *plugin);
 
-    bool connected() const;
-    double temperature() const;
-    double humidity() const;
+    quint64 suppressedReportCount() const override;
 
-private:
-    ZigbeeNode *m_node = nullptr;
-
-    bool m_connected = false;
-    double m_temperature = 0;
-    double m_humidity = 0;
+protected:
+    void resizeDevices(int count) override;
+    void resetDevice(int deviceId) override;
+    void setupDevice(int deviceId) override;
 
-    void setConnected(bool connected);
-    void setTemperature(double temperature);
-    void setHumidity(double humidity);
+private:
+    QVector<double> m_temperature;
+    QVector<double> m_humidity;
 
-signals:
-    void connectedChanged(bool connected);
-    void temperatureChanged(double temperature);
-    void humidityChanged(double humidity);
+    ZigbeeReportFilter m_temperatureFilter;
+    ZigbeeReportFilter m_humidityFilter;
 
-private slots:
-    void onNodeConnectedChanged(bool connected);
-    void onClusterAttributeChanged(ZigbeeCluster *cluster, const ZigbeeClusterAttribute &attribute);
+    void applySettings(int deviceId);
 
+    void onTemperatureReport(int deviceId, const QByteArray &data);
+    void onHumidityReport(int deviceId, const QByteArray &data);
 };
 
-#endif // XIAOMITEMPERATURESENSOR_H
+#endif // XIAOMITEMPERATURESENSORHANDLER_H
@@ -0,0 +1,68 @@
+# Plugin sources, shared with the benchmarks and the load test in tests/
+
+QT += serialport
+
+INCLUDEPATH += $$PWD
+
+CONFIG += link_pkgconfig
+PKGCONFIG += nymea-zigbee
+
+# Per hop report latency tracing, build with qmake CONFIG+=zigbee_tracing
+zigbee_tracing {
+    DEFINES += ZIGBEE_TRACING
+    SOURCES += $$PWD/zigbeetrace.cpp
+}
+
+SOURCES += \
+    $$PWD/integrationpluginzigbee.cpp \
+    $$PWD/zigbeeattributerouter.cpp \
+    $$PWD/zigbeecommandscheduler.cpp \
+    $$PWD/zigbeedevicedefinitions.cpp \
+    $$PWD/zigbeeeventlog.cpp \
+    $$PWD/zigbeelatencyhistogram.cpp \
+    $$PWD/zigbeenetworkthread.cpp \
+    $$PWD/zigbeenetworkworker.cpp \
+    $$PWD/zigbeenodeinterviewer.cpp \
+    $$PWD/zigbeenodesnapshot.cpp \
+    $$PWD/zigbeereportfilter.cpp \
+    $$PWD/zigbeereportqueue.cpp \
+    $$PWD/zigbeesensorhandler.cpp \
+    $$PWD/zigbeeserialproxy.cpp \
+    $$PWD/zigbeesetupqueue.cpp \
+    $$PWD/zigbeethinghandler.cpp \
+    $$PWD/zigbeetimerwheel.cpp \
+    $$PWD/zigbeetopology.cpp \
+    $$PWD/zigbeetopologycrawler.cpp \
+    $$PWD/xiaomi/xiaomibuttonsensorhandler.cpp \
+    $$PWD/xiaomi/xiaomimagnetsensorhandler.cpp \
+    $$PWD/xiaomi/xiaomimotionsensorhandler.cpp \
+    $$PWD/xiaomi/xiaomitemperaturesensorhandler.cpp
+
+HEADERS += \
+    $$PWD/integrationpluginzigbee.h \
+    $$PWD/thingregistry.h \
+    $$PWD/zigbeeattributedecoder.h \
+    $$PWD/zigbeeattributerouter.h \
+    $$PWD/zigbeecommandscheduler.h \
+    $$PWD/zigbeedevicedefinitions.h \
+    $$PWD/zigbeeeventlog.h \
+    $$PWD/zigbeelatencyhistogram.h \
+    $$PWD/zigbeenetworkthread.h \
+    $$PWD/zigbeenetworkworker.h \
+    $$PWD/zigbeenodeinfo.h \
+    $$PWD/zigbeenodeinterviewer.h \
+    $$PWD/zigbeenodesnapshot.h \
+    $$PWD/zigbeereportfilter.h \
+    $$PWD/zigbeereportqueue.h \
+    $$PWD/zigbeesensorhandler.h \
+    $$PWD/zigbeeserialproxy.h \
+    $$PWD/zigbeesetupqueue.h \
+    $$PWD/zigbeethinghandler.h \
+    $$PWD/zigbeetimerwheel.h \
+    $$PWD/zigbeetopology.h \
+    $$PWD/zigbeetopologycrawler.h \
+    $$PWD/zigbeetrace.h \
+    $$PWD/xiaomi/xiaomibuttonsensorhandler.h \
+    $$PWD/xiaomi/xiaomimagnetsensorhandler.h \
+    $$PWD/xiaomi/xiaomimotionsensorhandler.h \
+    $$PWD/xiaomi/xiaomitemperaturesensorhandler.h
@@ -16,22 +16,8 @@ isEmpty(PLUGIN_PRI) {
   include($$PLUGIN_PRI)
 }
 
-QT += serialport
-
-CONFIG += link_pkgconfig
-PKGCONFIG += nymea-zigbee
-
-SOURCES += \
-    integrationpluginzigbee.cpp \
-    xiaomi/xiaomibuttonsensor.cpp \
-    xiaomi/xiaomimagnetsensor.cpp \
-    xiaomi/xiaomimotionsensor.cpp \
-    xiaomi/xiaomitemperaturesensor.cpp
-
-HEADERS += \
-    integrationpluginzigbee.h \
-    xiaomi/xiaomibuttonsensor.h \
-    xiaomi/xiaomimagnetsensor.h \
-    xiaomi/xiaomimotionsensor.h \
-    xiaomi/xiaomitemperaturesensor.h
+include(zigbee.pri)
 
+# Benchmarks and the load test against the simulated coordinator, they build in tests/ on demand
+check.commands = $(MKDIR) tests && cd tests && $(QMAKE) $$PWD/tests/tests.pro && $(MAKE) && $(MAKE) check
+QMAKE_EXTRA_TARGETS += check
@@ -0,0 +1,84 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEEATTRIBUTEDECODER_H
+#define ZIGBEEATTRIBUTEDECODER_H
+
+#include <QtEndian>
+#include <QByteArray>
+
+// ZCL data types, the value type is the C++ type the attribute data decodes to
+struct ZclBool { typedef bool ValueType; typedef quint8 RawType; };
+struct ZclUint8 { typedef quint8 ValueType; typedef quint8 RawType; };
+struct ZclInt8 { typedef qint8 ValueType; typedef qint8 RawType; };
+struct ZclUint16 { typedef quint16 ValueType; typedef quint16 RawType; };
+struct ZclInt16 { typedef qint16 ValueType; typedef qint16 RawType; };
+struct ZclUint32 { typedef quint32 ValueType; typedef quint32 RawType; };
+struct ZclInt32 { typedef qint32 ValueType; typedef qint32 RawType; };
+
+// Decodes attribute data in place without copying the buffer. The controller
+// delivers attribute values in network byte order (big endian).
+namespace ZigbeeAttributeDecoder {
+
+template <typename T>
+inline typename T::ValueType decode(const char *data, int length, bool *ok = nullptr)
+{
+    typedef typename T::RawType RawType;
+    if (!data || length < static_cast<int>(sizeof(RawType))) {
+        if (ok) *ok = false;
+        return typename T::ValueType();
+    }
+
+    if (ok) *ok = true;
+    return static_cast<typename T::ValueType>(qFromBigEndian<RawType>(data));
+}
+
+template <>
+inline bool decode<ZclBool>(const char *data, int length, bool *ok)
+{
+    if (!data || length < 1) {
+        if (ok) *ok = false;
+        return false;
+    }
+
+    if (ok) *ok = true;
+    return data[0] != 0;
+}
+
+template <typename T>
+inline typename T::ValueType decode(const QByteArray &data, bool *ok = nullptr)
+{
+    return decode<T>(data.constData(), data.size(), ok);
+}
+
+}
+
+#endif // ZIGBEEATTRIBUTEDECODER_H
@@ -0,0 +1,168 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeeattributerouter.h"
+#include "zigbeenodesnapshot.h"
+#include "extern-plugininfo.h"
+
+ZigbeeAttributeRouter::ZigbeeAttributeRouter(QObject *parent) :
+    QObject(parent)
+{
+
+}
+
+void ZigbeeAttributeRouter::setSnapshot(ZigbeeNodeSnapshot *snapshot)
+{
+    m_snapshot = snapshot;
+}
+
+void ZigbeeAttributeRouter::registerAttribute(const ThingClassId &thingClassId, quint16 clusterId, quint16 attributeId, AttributeHandler handler, bool initialize)
+{
+    AttributeRoute route;
+    route.handler = handler;
+    route.initialize = initialize;
+    m_attributeTables[thingClassId].insert(attributeKey(clusterId, attributeId), route);
+}
+
+void ZigbeeAttributeRouter::registerCluster(const ThingClassId &thingClassId, quint16 clusterId, AttributeHandler handler)
+{
+    m_clusterTables[thingClassId].insert(clusterId, handler);
+}
+
+void ZigbeeAttributeRouter::registerConnectedHandler(const ThingClassId &thingClassId, ConnectedHandler handler)
+{
+    m_connectedHandlers.insert(thingClassId, handler);
+}
+
+void ZigbeeAttributeRouter::addNode(const ZigbeeNodeInfo &node, Thing *thing, int deviceId)
+{
+    removeThing(thing);
+    m_thingNodes.remove(m_routes.value(node.ieeeAddress).thing);
+
+    NodeRoute route;
+    route.thing = thing;
+    route.deviceId = deviceId;
+    route.attributes = &m_attributeTables[thing->thingClassId()];
+    route.clusters = &m_clusterTables[thing->thingClassId()];
+    route.connectedHandler = m_connectedHandlers.value(thing->thingClassId());
+    m_routes.insert(node.ieeeAddress, route);
+    m_thingNodes.insert(thing, node.ieeeAddress);
+    initializeRoute(node, route);
+}
+
+void ZigbeeAttributeRouter::updateNode(const ZigbeeNodeInfo &node)
+{
+    QHash<quint64, NodeRoute>::const_iterator it = m_routes.constFind(node.ieeeAddress);
+    if (it == m_routes.constEnd())
+        return;
+
+    initializeRoute(node, it.value());
+}
+
+void ZigbeeAttributeRouter::initializeRoute(const ZigbeeNodeInfo &node, const NodeRoute &route)
+{
+    if (m_snapshot) {
+        m_snapshot->updateNode(node.ieeeAddress, node.shortAddress, node.inputClusters, node.outputClusters);
+    }
+
+    // Init values, the node knows better than the snapshot
+    if (route.connectedHandler) {
+        route.connectedHandler(route.deviceId, node.connected);
+    }
+
+    for (AttributeTable::const_iterator it = route.attributes->constBegin(); it != route.attributes->constEnd(); ++it) {
+        if (!it.value().initialize)
+            continue;
+
+        quint16 clusterId = static_cast<quint16>(it.key() >> 16);
+        quint16 attributeId = static_cast<quint16>(it.key() & 0xffff);
+        if (node.hasOutputCluster(clusterId) && node.hasAttribute(clusterId, attributeId)) {
+            QByteArray data = node.attribute(clusterId, attributeId);
+            if (m_snapshot) {
+                m_snapshot->updateAttribute(node.ieeeAddress, clusterId, attributeId, data);
+            }
+            it.value().handler(route.deviceId, data);
+        } else if (m_snapshot) {
+            QByteArray data = m_snapshot->attribute(node.ieeeAddress, clusterId, attributeId);
+            if (!data.isEmpty()) {
+                it.value().handler(route.deviceId, data);
+            }
+        }
+    }
+}
+
+void ZigbeeAttributeRouter::removeThing(Thing *thing)
+{
+    if (!m_thingNodes.contains(thing))
+        return;
+
+    m_routes.remove(m_thingNodes.take(thing));
+}
+
+void ZigbeeAttributeRouter::onNodeConnectedChanged(quint64 ieeeAddress, bool connected)
+{
+    QHash<quint64, NodeRoute>::const_iterator it = m_routes.constFind(ieeeAddress);
+    if (it == m_routes.constEnd() || !it.value().connectedHandler)
+        return;
+
+    it.value().connectedHandler(it.value().deviceId, connected);
+}
+
+void ZigbeeAttributeRouter::onAttributeChanged(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data)
+{
+    QHash<quint64, NodeRoute>::const_iterator it = m_routes.constFind(ieeeAddress);
+    if (it == m_routes.constEnd())
+        return;
+
+    const NodeRoute &route = it.value();
+    const AttributeHandler *handler = nullptr;
+    AttributeTable::const_iterator attributeIt = route.attributes->constFind(attributeKey(clusterId, attributeId));
+    if (attributeIt != route.attributes->constEnd()) {
+        handler = &attributeIt.value().handler;
+    } else {
+        ClusterTable::const_iterator clusterIt = route.clusters->constFind(clusterId);
+        if (clusterIt == route.clusters->constEnd())
+            return;
+
+        handler = &clusterIt.value();
+    }
+
+    if (m_snapshot) {
+        m_snapshot->updateAttribute(ieeeAddress, clusterId, attributeId, data);
+    }
+
+    (*handler)(route.deviceId, data);
+}
+
+quint32 ZigbeeAttributeRouter::attributeKey(quint16 clusterId, quint16 attributeId)
+{
+    return static_cast<quint32>(clusterId) << 16 | attributeId;
+}
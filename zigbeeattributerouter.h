@@ -0,0 +1,107 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEEATTRIBUTEROUTER_H
+#define ZIGBEEATTRIBUTEROUTER_H
+
+#include <QHash>
+#include <QObject>
+
+#include <functional>
+
+#include <integrations/thing.h>
+
+#include "zigbeenodeinfo.h"
+
+class ZigbeeNodeSnapshot;
+
+// Dispatches the attribute reports of the networks on the node ieee address and the
+// (cluster id, attribute id) pair straight to the thing class handling the node.
+// Handlers get called with the device id the node has been added with and the raw attribute data.
+class ZigbeeAttributeRouter : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<void(int deviceId, const QByteArray &data)> AttributeHandler;
+    typedef std::function<void(int deviceId, bool connected)> ConnectedHandler;
+
+    explicit ZigbeeAttributeRouter(QObject *parent = nullptr);
+
+    // Routed attribute values get recorded in the snapshot and the snapshot provides the
+    // initial values for attributes the node does not know yet.
+    void setSnapshot(ZigbeeNodeSnapshot *snapshot);
+
+    // Registration has to happen before the first node gets added. If initialize is set, the
+    // attribute value already known by the node gets dispatched once when the node is added.
+    void registerAttribute(const ThingClassId &thingClassId, quint16 clusterId, quint16 attributeId, AttributeHandler handler, bool initialize = true);
+    // Catches every attribute of the cluster without an own registration. Never initialized.
+    void registerCluster(const ThingClassId &thingClassId, quint16 clusterId, AttributeHandler handler);
+    void registerConnectedHandler(const ThingClassId &thingClassId, ConnectedHandler handler);
+
+    void addNode(const ZigbeeNodeInfo &node, Thing *thing, int deviceId);
+    // The live node showed up for a thing set up from the snapshot, dispatches its values again
+    void updateNode(const ZigbeeNodeInfo &node);
+    void removeThing(Thing *thing);
+
+public slots:
+    void onNodeConnectedChanged(quint64 ieeeAddress, bool connected);
+    void onAttributeChanged(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data);
+
+private:
+    struct AttributeRoute {
+        AttributeHandler handler;
+        bool initialize = true;
+    };
+    typedef QHash<quint32, AttributeRoute> AttributeTable;
+    typedef QHash<quint16, AttributeHandler> ClusterTable;
+
+    struct NodeRoute {
+        Thing *thing = nullptr;
+        int deviceId = -1;
+        const AttributeTable *attributes = nullptr;
+        const ClusterTable *clusters = nullptr;
+        ConnectedHandler connectedHandler;
+    };
+
+    ZigbeeNodeSnapshot *m_snapshot = nullptr;
+
+    QHash<ThingClassId, AttributeTable> m_attributeTables;
+    QHash<ThingClassId, ClusterTable> m_clusterTables;
+    QHash<ThingClassId, ConnectedHandler> m_connectedHandlers;
+
+    QHash<quint64, NodeRoute> m_routes;
+    QHash<Thing *, quint64> m_thingNodes;
+
+    static quint32 attributeKey(quint16 clusterId, quint16 attributeId);
+    void initializeRoute(const ZigbeeNodeInfo &node, const NodeRoute &route);
+};
+
+#endif // ZIGBEEATTRIBUTEROUTER_H
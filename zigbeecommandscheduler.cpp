@@ -0,0 +1,168 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeecommandscheduler.h"
+#include "zigbeereportqueue.h"
+#include "zigbeenetworkmanager.h"
+#include "extern-plugininfo.h"
+
+#include <QTimer>
+#include <QPointer>
+#include <QSharedPointer>
+
+ZigbeeCommandScheduler::ZigbeeCommandScheduler(QObject *parent) :
+    QObject(parent)
+{
+
+}
+
+void ZigbeeCommandScheduler::enqueue(Priority priority, quint16 nodeAddress, quint32 mergeKey, Sender sender)
+{
+    // Latest wins, the command keeps the best lane and the oldest position
+    if (mergeKey != 0) {
+        for (int lane = 0; lane < PriorityCount; lane++) {
+            for (int i = 0; i < m_lanes[lane].count(); i++) {
+                Command &command = m_lanes[lane][i];
+                if (command.nodeAddress != nodeAddress || command.mergeKey != mergeKey)
+                    continue;
+
+                command.sender = sender;
+                if (priority < lane) {
+                    // Sorted into the better lane by the time it got enqueued first
+                    Command merged = m_lanes[lane].takeAt(i);
+                    int position = 0;
+                    while (position < m_lanes[priority].count() && m_lanes[priority].at(position).enqueued <= merged.enqueued)
+                        position++;
+
+                    m_lanes[priority].insert(position, merged);
+                }
+
+                // The merged command counts as finished
+                emit commandFinished();
+                schedule();
+                return;
+            }
+        }
+    }
+
+    Command command;
+    command.nodeAddress = nodeAddress;
+    command.mergeKey = mergeKey;
+    command.enqueued = ZigbeeReportQueue::timestamp();
+    command.sender = sender;
+    m_lanes[priority].append(command);
+
+    schedule();
+}
+
+double ZigbeeCommandScheduler::waitTimeMedian() const
+{
+    return m_waitTime.percentile(0.5) / 1000.0;
+}
+
+double ZigbeeCommandScheduler::waitTime95() const
+{
+    return m_waitTime.percentile(0.95) / 1000.0;
+}
+
+void ZigbeeCommandScheduler::resetStatistics()
+{
+    m_waitTime.reset();
+}
+
+void ZigbeeCommandScheduler::schedule()
+{
+    // Commands finishing right away must not schedule recursively
+    if (m_scheduling)
+        return;
+
+    m_scheduling = true;
+    bool sent = true;
+    while (sent) {
+        sent = false;
+        for (int lane = 0; lane < PriorityCount && !sent && m_inFlight < maxInFlight; lane++) {
+            for (int i = 0; i < m_lanes[lane].count(); i++) {
+                if (m_inFlightPerNode.value(m_lanes[lane].at(i).nodeAddress) >= maxInFlightPerNode)
+                    continue;
+
+                Command command = m_lanes[lane].takeAt(i);
+                send(command);
+                sent = true;
+                break;
+            }
+        }
+    }
+    m_scheduling = false;
+}
+
+void ZigbeeCommandScheduler::send(const Command &command)
+{
+    m_waitTime.add(ZigbeeReportQueue::timestamp() - command.enqueued);
+
+    m_inFlight++;
+    m_inFlightPerNode[command.nodeAddress]++;
+
+    quint16 nodeAddress = command.nodeAddress;
+    QPointer<ZigbeeInterfaceReply> reply = command.sender();
+    if (!reply) {
+        finish(nodeAddress);
+        return;
+    }
+
+    // Whichever comes first, the reply or the timeout
+    QSharedPointer<bool> finished(new bool(false));
+    connect(reply.data(), &ZigbeeInterfaceReply::finished, this, [this, nodeAddress, finished](){
+        if (*finished)
+            return;
+
+        *finished = true;
+        finish(nodeAddress);
+    });
+    QTimer::singleShot(commandTimeout, this, [this, nodeAddress, finished](){
+        if (*finished)
+            return;
+
+        qCWarning(dcZigbee()) << "Command for node" << nodeAddress << "timed out";
+        *finished = true;
+        finish(nodeAddress);
+    });
+}
+
+void ZigbeeCommandScheduler::finish(quint16 nodeAddress)
+{
+    m_inFlight--;
+    if (--m_inFlightPerNode[nodeAddress] <= 0) {
+        m_inFlightPerNode.remove(nodeAddress);
+    }
+
+    emit commandFinished();
+    schedule();
+}
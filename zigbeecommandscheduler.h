@@ -0,0 +1,100 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEECOMMANDSCHEDULER_H
+#define ZIGBEECOMMANDSCHEDULER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include <functional>
+
+#include "zigbeelatencyhistogram.h"
+
+class ZigbeeInterfaceReply;
+
+// Queues the outbound commands of one network in front of the coordinator. Commands are
+// sent by priority lane, with a limited number in flight per node and in total. A queued
+// command gets replaced by a newer one with the same merge key, the latest wins.
+// Lives in the network thread, the statistics included.
+class ZigbeeCommandScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        PriorityUser,
+        PriorityRule,
+        PriorityMaintenance,
+        PriorityCount
+    };
+
+    // Sends the command, returns the reply to wait for or nullptr if it is done already
+    typedef std::function<ZigbeeInterfaceReply *()> Sender;
+
+    explicit ZigbeeCommandScheduler(QObject *parent = nullptr);
+
+    // A merge key of 0 never merges
+    void enqueue(Priority priority, quint16 nodeAddress, quint32 mergeKey, Sender sender);
+
+    // Time from enqueueing until sending in ms
+    double waitTimeMedian() const;
+    double waitTime95() const;
+    void resetStatistics();
+
+signals:
+    void commandFinished();
+
+private:
+    struct Command {
+        quint16 nodeAddress = 0;
+        quint32 mergeKey = 0;
+        qint64 enqueued = 0;
+        Sender sender;
+    };
+
+    static const int maxInFlightPerNode = 1;
+    static const int maxInFlight = 4;
+    static const int commandTimeout = 10000;
+
+    QList<Command> m_lanes[PriorityCount];
+    QHash<quint16, int> m_inFlightPerNode;
+    int m_inFlight = 0;
+    bool m_scheduling = false;
+
+    ZigbeeLatencyHistogram m_waitTime;
+
+    void schedule();
+    void send(const Command &command);
+    void finish(quint16 nodeAddress);
+};
+
+#endif // ZIGBEECOMMANDSCHEDULER_H
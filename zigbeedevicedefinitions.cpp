@@ -0,0 +1,76 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeedevicedefinitions.h"
+
+void ZigbeeDeviceDefinitions::addDefinition(const QString &modelIdentifier, const ThingClassId &thingClassId, const ParamTypeId &ieeeAddressParamTypeId, const char *title)
+{
+    ZigbeeDeviceDefinition definition;
+    definition.modelIdentifier = modelIdentifier;
+    definition.thingClassId = thingClassId;
+    definition.ieeeAddressParamTypeId = ieeeAddressParamTypeId;
+    definition.title = title;
+    if (!m_definitions.contains(modelIdentifier))
+        m_modelIdentifiers.append(modelIdentifier);
+
+    m_definitions.insert(modelIdentifier, definition);
+}
+
+const ZigbeeDeviceDefinition *ZigbeeDeviceDefinitions::findDefinition(const QString &modelIdentifier) const
+{
+    // The string attribute sometimes carries the terminating NUL of the device
+    QString model = modelIdentifier;
+    while (model.endsWith(QChar::Null))
+        model.chop(1);
+
+    model = model.trimmed();
+    QString identifier = model;
+    while (!identifier.isEmpty()) {
+        QHash<QString, ZigbeeDeviceDefinition>::const_iterator it = m_definitions.constFind(identifier);
+        if (it != m_definitions.constEnd())
+            return &it.value();
+
+        int index = identifier.lastIndexOf('.');
+        if (index < 0)
+            break;
+
+        identifier.truncate(index);
+    }
+
+    // Suffixes without a dot, the way the model identifiers always got matched before
+    foreach (const QString &knownIdentifier, m_modelIdentifiers) {
+        if (model.contains(knownIdentifier)) {
+            return &m_definitions.constFind(knownIdentifier).value();
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,67 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEEDEVICEDEFINITIONS_H
+#define ZIGBEEDEVICEDEFINITIONS_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include <typeutils.h>
+
+struct ZigbeeDeviceDefinition
+{
+    QString modelIdentifier;
+    ThingClassId thingClassId;
+    ParamTypeId ieeeAddressParamTypeId;
+    const char *title = nullptr;
+};
+
+// Maps Basic cluster model identifiers to the thing class handling the device
+class ZigbeeDeviceDefinitions
+{
+public:
+    void addDefinition(const QString &modelIdentifier, const ThingClassId &thingClassId, const ParamTypeId &ieeeAddressParamTypeId, const char *title);
+
+    // Returns the definition registered for the model identifier or for the longest
+    // dot separated prefix of it, i.e. "lumi.sensor_magnet.aq2" matches "lumi.sensor_magnet".
+    // Trailing NUL characters some devices send get ignored. Identifiers without a match
+    // fall back to the first registered model contained in them, like "lumi.sensor_switch_aq2".
+    const ZigbeeDeviceDefinition *findDefinition(const QString &modelIdentifier) const;
+
+private:
+    QHash<QString, ZigbeeDeviceDefinition> m_definitions;
+    // Registration order for the fallback scan
+    QList<QString> m_modelIdentifiers;
+};
+
+#endif // ZIGBEEDEVICEDEFINITIONS_H
@@ -0,0 +1,78 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeeeventlog.h"
+#include "zigbeeaddress.h"
+#include "extern-plugininfo.h"
+
+#include <QDateTime>
+
+ZigbeeEventLog::ZigbeeEventLog(int capacity) :
+    m_entries(capacity)
+{
+
+}
+
+void ZigbeeEventLog::record(Type type, quint64 subject, double value)
+{
+    Entry &entry = m_entries[static_cast<int>(m_count % static_cast<quint64>(m_entries.count()))];
+    entry.timestamp = QDateTime::currentMSecsSinceEpoch();
+    entry.subject = subject;
+    entry.value = value;
+    entry.type = type;
+    m_count++;
+}
+
+void ZigbeeEventLog::dump() const
+{
+    static const char *typeNames[] = {
+        "node classified, output clusters",
+        "magnet opened",
+        "magnet closed",
+        "temperature",
+        "humidity",
+        "button pressed",
+        "button released",
+        "button clicked",
+        "button long pressed",
+        "motion detected",
+        "presence changed"
+    };
+
+    quint64 capacity = static_cast<quint64>(m_entries.count());
+    quint64 first = m_count > capacity ? m_count - capacity : 0;
+    qCInfo(dcZigbee()) << "Event log," << m_count - first << "of" << m_count << "events:";
+    for (quint64 i = first; i < m_count; i++) {
+        const Entry &entry = m_entries.at(static_cast<int>(i % capacity));
+        qCInfo(dcZigbee()).noquote() << "   " << QDateTime::fromMSecsSinceEpoch(entry.timestamp).toString("hh:mm:ss.zzz")
+                                     << ZigbeeAddress(entry.subject).toString() << typeNames[entry.type] << entry.value;
+    }
+}
@@ -0,0 +1,75 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeelatencyhistogram.h"
+
+void ZigbeeLatencyHistogram::add(qint64 usec)
+{
+    // Bucket n holds [2^(n-1), 2^n) us, bucket 0 everything below 1 us
+    int bucket = 0;
+    quint64 value = usec > 0 ? static_cast<quint64>(usec) : 0;
+    while (value && bucket < BucketCount - 1) {
+        value >>= 1;
+        bucket++;
+    }
+
+    m_buckets[bucket]++;
+    m_count++;
+}
+
+void ZigbeeLatencyHistogram::reset()
+{
+    for (int i = 0; i < BucketCount; i++)
+        m_buckets[i] = 0;
+
+    m_count = 0;
+}
+
+quint64 ZigbeeLatencyHistogram::count() const
+{
+    return m_count;
+}
+
+qint64 ZigbeeLatencyHistogram::percentile(double fraction) const
+{
+    if (m_count == 0)
+        return 0;
+
+    quint64 rank = static_cast<quint64>(fraction * m_count);
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; i++) {
+        seen += m_buckets[i];
+        if (seen > rank)
+            return i == 0 ? 0 : (Q_INT64_C(1) << i);
+    }
+
+    return Q_INT64_C(1) << (BucketCount - 1);
+}
@@ -0,0 +1,339 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeenetworkthread.h"
+#include "zigbeetrace.h"
+#include "zigbeenetworkworker.h"
+#include "extern-plugininfo.h"
+
+#include <cstring>
+
+ZigbeeNetworkThread::ZigbeeNetworkThread(QObject *parent) :
+    QObject(parent),
+    m_criticalQueue(256),
+    m_bulkQueue(1024)
+{
+    qRegisterMetaType<ZigbeeNetworkInfo>();
+    qRegisterMetaType<ZigbeeNodeInfo>();
+    qRegisterMetaType<QList<ZigbeeNeighbor> >();
+    qRegisterMetaType<ZigbeeNetworkStatistics>();
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName("zigbee-network");
+
+    m_worker = new ZigbeeNetworkWorker(&m_criticalQueue, &m_bulkQueue, &m_pendingCommands);
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+
+    connect(m_worker, &ZigbeeNetworkWorker::networkInfoChanged, this, &ZigbeeNetworkThread::onNetworkInfoChanged);
+    connect(m_worker, &ZigbeeNetworkWorker::nodeAdded, this, &ZigbeeNetworkThread::onNodeAdded);
+    connect(m_worker, &ZigbeeNetworkWorker::nodeInterviewed, this, &ZigbeeNetworkThread::onNodeInterviewed);
+    connect(m_worker, &ZigbeeNetworkWorker::nodeRemoved, this, &ZigbeeNetworkThread::onNodeRemoved);
+    connect(m_worker, &ZigbeeNetworkWorker::nodeConnectedChanged, this, &ZigbeeNetworkThread::onNodeConnectedChanged);
+    connect(m_worker, &ZigbeeNetworkWorker::reportsAvailable, this, &ZigbeeNetworkThread::onReportsAvailable);
+    connect(m_worker, &ZigbeeNetworkWorker::neighborTableReceived, this, &ZigbeeNetworkThread::onNeighborTableReceived);
+    connect(m_worker, &ZigbeeNetworkWorker::commandStatisticsTaken, this, &ZigbeeNetworkThread::onCommandStatisticsTaken);
+
+    m_statisticsTimer.start();
+    m_thread->start();
+}
+
+ZigbeeNetworkThread::~ZigbeeNetworkThread()
+{
+    // The worker and the network manager get deleted in the network thread once it finished
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void ZigbeeNetworkThread::setSerialCapture(const QString &captureFileName)
+{
+    QMetaObject::invokeMethod(m_worker, "setSerialCapture", Qt::QueuedConnection, Q_ARG(QString, captureFileName));
+}
+
+void ZigbeeNetworkThread::setSerialReplay(const QString &replayFileName, bool realTime)
+{
+    QMetaObject::invokeMethod(m_worker, "setSerialReplay", Qt::QueuedConnection, Q_ARG(QString, replayFileName), Q_ARG(bool, realTime));
+}
+
+void ZigbeeNetworkThread::startNetwork(const QString &serialPortName, qint32 baudrate, const QString &settingsFileName)
+{
+    QMetaObject::invokeMethod(m_worker, "startNetwork", Qt::QueuedConnection, Q_ARG(QString, serialPortName), Q_ARG(qint32, baudrate), Q_ARG(QString, settingsFileName));
+}
+
+void ZigbeeNetworkThread::setPermitJoining(bool permitJoining, ZigbeeCommandScheduler::Priority priority)
+{
+    m_pendingCommands.ref();
+    QMetaObject::invokeMethod(m_worker, "setPermitJoining", Qt::QueuedConnection, Q_ARG(bool, permitJoining), Q_ARG(int, priority));
+}
+
+void ZigbeeNetworkThread::factoryResetNetwork(ZigbeeCommandScheduler::Priority priority)
+{
+    m_pendingCommands.ref();
+    QMetaObject::invokeMethod(m_worker, "factoryResetNetwork", Qt::QueuedConnection, Q_ARG(int, priority));
+}
+
+void ZigbeeNetworkThread::requestLinkQuality(quint16 shortAddress, ZigbeeCommandScheduler::Priority priority)
+{
+    m_pendingCommands.ref();
+    QMetaObject::invokeMethod(m_worker, "requestLinkQuality", Qt::QueuedConnection, Q_ARG(quint16, shortAddress), Q_ARG(int, priority));
+}
+
+void ZigbeeNetworkThread::crawlTopology()
+{
+    QMetaObject::invokeMethod(m_worker, "crawlTopology", Qt::QueuedConnection);
+}
+
+ZigbeeNetworkInfo ZigbeeNetworkThread::networkInfo() const
+{
+    return m_networkInfo;
+}
+
+ZigbeeNetwork::State ZigbeeNetworkThread::state() const
+{
+    return m_networkInfo.state;
+}
+
+void ZigbeeNetworkThread::requestStatistics()
+{
+    // The command scheduler belongs to the network thread, it takes its part there
+    QMetaObject::invokeMethod(m_worker, "takeCommandStatistics", Qt::QueuedConnection);
+}
+
+void ZigbeeNetworkThread::onCommandStatisticsTaken(double waitTimeMedian, double waitTime95)
+{
+    ZigbeeNetworkStatistics statistics;
+    qint64 elapsed = m_statisticsTimer.restart();
+    if (elapsed > 0) {
+        statistics.reportRate = m_reportCount * 1000.0 / elapsed;
+    }
+    statistics.reportLatencyMedian = m_reportLatency.percentile(0.5) / 1000.0;
+    statistics.reportLatency95 = m_reportLatency.percentile(0.95) / 1000.0;
+    statistics.criticalReportLatency95 = m_criticalReportLatency.percentile(0.95) / 1000.0;
+    statistics.droppedReports = m_criticalQueue.overflowCount() + m_bulkQueue.overflowCount();
+    statistics.pendingCommands = m_pendingCommands.loadAcquire();
+    statistics.commandWaitMedian = waitTimeMedian;
+    statistics.commandWait95 = waitTime95;
+
+    m_reportCount = 0;
+    m_reportLatency.reset();
+    m_criticalReportLatency.reset();
+    emit statisticsTaken(statistics);
+}
+
+QList<ZigbeeNodeInfo> ZigbeeNetworkThread::nodes() const
+{
+    return m_nodes.values();
+}
+
+const ZigbeeNodeInfo *ZigbeeNetworkThread::node(quint64 ieeeAddress) const
+{
+    QHash<quint64, ZigbeeNodeInfo>::const_iterator it = m_nodes.constFind(ieeeAddress);
+    if (it == m_nodes.constEnd())
+        return nullptr;
+
+    return &it.value();
+}
+
+void ZigbeeNetworkThread::restoreNode(const ZigbeeNodeInfo &node)
+{
+    // The network knows better
+    if (m_nodes.contains(node.ieeeAddress))
+        return;
+
+    m_nodes.insert(node.ieeeAddress, node);
+}
+
+const ZigbeeTopology &ZigbeeNetworkThread::topology() const
+{
+    return m_topology;
+}
+
+#ifdef ZIGBEE_TESTING
+void ZigbeeNetworkThread::dispatchReport(const ZigbeeAttributeReport &report)
+{
+    ZigbeeAttributeReport queuedReport = report;
+    queuedReport.timestamp = ZigbeeReportQueue::timestamp();
+    m_bulkQueue.push(queuedReport);
+    onReportsAvailable();
+}
+#endif
+
+void ZigbeeNetworkThread::onNetworkInfoChanged(const ZigbeeNetworkInfo &networkInfo)
+{
+    ZigbeeNetworkInfo previousInfo = m_networkInfo;
+    m_networkInfo = networkInfo;
+
+    if (previousInfo.channel != networkInfo.channel)
+        emit channelChanged(networkInfo.channel);
+
+    if (previousInfo.extendedPanId != networkInfo.extendedPanId)
+        emit extendedPanIdChanged(networkInfo.extendedPanId);
+
+    if (previousInfo.permitJoining != networkInfo.permitJoining)
+        emit permitJoiningChanged(networkInfo.permitJoining);
+
+    if (previousInfo.state != networkInfo.state)
+        emit stateChanged(networkInfo.state);
+}
+
+void ZigbeeNetworkThread::onNodeAdded(const ZigbeeNodeInfo &node)
+{
+    m_nodes.insert(node.ieeeAddress, node);
+
+    // Nodes known before the network is running get handled all at once on the state change
+    if (m_networkInfo.state == ZigbeeNetwork::StateRunning) {
+        emit nodeAdded(node);
+    }
+}
+
+void ZigbeeNetworkThread::onNodeInterviewed(const ZigbeeNodeInfo &node)
+{
+    m_nodes.insert(node.ieeeAddress, node);
+
+    if (m_networkInfo.state == ZigbeeNetwork::StateRunning) {
+        emit nodeInterviewed(node);
+    }
+}
+
+void ZigbeeNetworkThread::onNodeRemoved(quint64 ieeeAddress)
+{
+    if (m_nodes.remove(ieeeAddress) > 0) {
+        emit nodeRemoved(ieeeAddress);
+    }
+}
+
+void ZigbeeNetworkThread::onNodeConnectedChanged(quint64 ieeeAddress, bool connected)
+{
+    QHash<quint64, ZigbeeNodeInfo>::iterator it = m_nodes.find(ieeeAddress);
+    if (it == m_nodes.end())
+        return;
+
+    it.value().connected = connected;
+    emit nodeConnectedChanged(ieeeAddress, connected);
+}
+
+void ZigbeeNetworkThread::onReportsAvailable()
+{
+    // The pending retry continues with the queues, the deferred reports go first
+    if (!m_deferredReports.isEmpty())
+        return;
+
+    // Reports queued from now on need a new wakeup
+    m_criticalQueue.clearNotification();
+    m_bulkQueue.clearNotification();
+
+    // The critical lane gets emptied before every bulk batch, so a critical report
+    // waits for one small batch at most, even while a report storm is going on.
+    ZigbeeAttributeReport reports[16];
+    QByteArray longValues[16];
+    forever {
+        bool critical = true;
+        int count = m_criticalQueue.pop(reports, 16, longValues);
+        if (count == 0) {
+            critical = false;
+            count = m_bulkQueue.pop(reports, 16, longValues);
+        }
+
+        if (count == 0)
+            break;
+
+        // A report may overtake the queued nodeAdded of its node. The rest waits for a retry
+        // queued behind the nodeAdded, the remaining reports stay in the queues until then.
+        int dispatched = dispatchReports(reports, longValues, count, critical, true);
+        if (dispatched < count) {
+            for (int i = dispatched; i < count; i++) {
+                m_deferredReports.append(reports[i]);
+                m_deferredLongValues.append(longValues[i]);
+            }
+            m_deferredCritical = critical;
+            QMetaObject::invokeMethod(this, "onDeferredReportsRetry", Qt::QueuedConnection);
+            break;
+        }
+    }
+
+    quint32 overflowCount = m_criticalQueue.overflowCount() + m_bulkQueue.overflowCount();
+    if (overflowCount != m_reportedOverflowCount) {
+        qCWarning(dcZigbee()) << "Dropped" << overflowCount - m_reportedOverflowCount << "attribute reports, the report queue was full";
+        m_reportedOverflowCount = overflowCount;
+    }
+}
+
+void ZigbeeNetworkThread::onDeferredReportsRetry()
+{
+    // Their nodeAdded has been processed before this retry, nodes still unknown are gone
+    QVector<ZigbeeAttributeReport> reports;
+    QVector<QByteArray> longValues;
+    reports.swap(m_deferredReports);
+    longValues.swap(m_deferredLongValues);
+    dispatchReports(reports.constData(), longValues.constData(), reports.count(), m_deferredCritical, false);
+    onReportsAvailable();
+}
+
+void ZigbeeNetworkThread::onNeighborTableReceived(quint16 shortAddress, const QList<ZigbeeNeighbor> &neighbors)
+{
+    m_topology.updateNeighbors(shortAddress, neighbors);
+}
+
+int ZigbeeNetworkThread::dispatchReports(const ZigbeeAttributeReport *reports, const QByteArray *longValues, int count, bool critical, bool deferUnknown)
+{
+    for (int i = 0; i < count; i++) {
+        const ZigbeeAttributeReport &report = reports[i];
+        QHash<quint64, ZigbeeNodeInfo>::iterator it = m_nodes.find(report.ieeeAddress);
+        if (it == m_nodes.end()) {
+            if (deferUnknown)
+                return i;
+
+            continue;
+        }
+
+        // Keep the cached value, receivers may hold on to the data
+        QByteArray &value = it.value().attributes[static_cast<quint32>(report.clusterId) << 16 | report.attributeId];
+        if (report.length == ZigbeeAttributeReport::LongValueLength) {
+            value = longValues[i];
+        } else if (value.size() != report.length || memcmp(value.constData(), report.data, report.length) != 0) {
+            value = QByteArray(report.data, report.length);
+        }
+
+        ZIGBEE_TRACE_BEGIN(report.timestamp);
+        ZIGBEE_TRACE(HopDispatched);
+        emit attributeChanged(report.ieeeAddress, report.clusterId, report.attributeId, value);
+        ZIGBEE_TRACE_END();
+
+        qint64 latency = ZigbeeReportQueue::timestamp() - report.timestamp;
+        m_reportCount++;
+        m_reportLatency.add(latency);
+        if (critical) {
+            m_criticalReportLatency.add(latency);
+        }
+    }
+
+    return count;
+}
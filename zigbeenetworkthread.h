@@ -0,0 +1,151 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEENETWORKTHREAD_H
+#define ZIGBEENETWORKTHREAD_H
+
+#include <QHash>
+#include <QVector>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QObject>
+
+#include "zigbeenodeinfo.h"
+#include "zigbeereportqueue.h"
+#include "zigbeelatencyhistogram.h"
+#include "zigbeetopology.h"
+#include "zigbeecommandscheduler.h"
+
+class ZigbeeNetworkWorker;
+
+struct ZigbeeNetworkStatistics
+{
+    double reportRate = 0;
+    double reportLatencyMedian = 0;
+    double reportLatency95 = 0;
+    double criticalReportLatency95 = 0;
+    quint32 droppedReports = 0;
+    int pendingCommands = 0;
+    double commandWaitMedian = 0;
+    double commandWait95 = 0;
+};
+Q_DECLARE_METATYPE(ZigbeeNetworkStatistics)
+
+// Runs one ZigbeeNetworkManager in its own thread, so serial I/O and frame decoding
+// don't depend on the main event loop. Commands are queued to the network thread,
+// the network and node state gets mirrored here and signaled in the main thread.
+class ZigbeeNetworkThread : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ZigbeeNetworkThread(QObject *parent = nullptr);
+    ~ZigbeeNetworkThread() override;
+
+    // Both have to be set before starting the network. A replay takes precedence over a capture.
+    void setSerialCapture(const QString &captureFileName);
+    void setSerialReplay(const QString &replayFileName, bool realTime);
+    void startNetwork(const QString &serialPortName, qint32 baudrate, const QString &settingsFileName);
+    void setPermitJoining(bool permitJoining, ZigbeeCommandScheduler::Priority priority);
+    void factoryResetNetwork(ZigbeeCommandScheduler::Priority priority);
+    void requestLinkQuality(quint16 shortAddress, ZigbeeCommandScheduler::Priority priority);
+    // Refreshes the topology in the background, it gets refreshed hourly anyways
+    void crawlTopology();
+
+    ZigbeeNetworkInfo networkInfo() const;
+    ZigbeeNetwork::State state() const;
+
+    // Statistics since the last request, delivered with statisticsTaken() once the network
+    // thread took its part. Latencies are in ms from receiving a report in the network
+    // thread until all state updates for it are done.
+    void requestStatistics();
+
+    QList<ZigbeeNodeInfo> nodes() const;
+    const ZigbeeNodeInfo *node(quint64 ieeeAddress) const;
+    // Makes a node known before the network reports it, i.e. from the last snapshot
+    void restoreNode(const ZigbeeNodeInfo &node);
+    const ZigbeeTopology &topology() const;
+
+#ifdef ZIGBEE_TESTING
+    // Queues the report like the network thread does and dispatches it right away
+    void dispatchReport(const ZigbeeAttributeReport &report);
+#endif
+
+signals:
+    void stateChanged(ZigbeeNetwork::State state);
+    void channelChanged(uint channel);
+    void extendedPanIdChanged(quint64 extendedPanId);
+    void permitJoiningChanged(bool permitJoining);
+    void nodeAdded(const ZigbeeNodeInfo &node);
+    // The Basic cluster of a node got read, it might be possible to classify it now
+    void nodeInterviewed(const ZigbeeNodeInfo &node);
+    void nodeRemoved(quint64 ieeeAddress);
+    void nodeConnectedChanged(quint64 ieeeAddress, bool connected);
+    void attributeChanged(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data);
+    void statisticsTaken(const ZigbeeNetworkStatistics &statistics);
+
+private:
+    QThread *m_thread = nullptr;
+    ZigbeeNetworkWorker *m_worker = nullptr;
+    ZigbeeReportQueue m_criticalQueue;
+    ZigbeeReportQueue m_bulkQueue;
+    quint32 m_reportedOverflowCount = 0;
+    // Reports which overtook the nodeAdded of their node
+    QVector<ZigbeeAttributeReport> m_deferredReports;
+    QVector<QByteArray> m_deferredLongValues;
+    bool m_deferredCritical = false;
+    QAtomicInt m_pendingCommands;
+
+    QElapsedTimer m_statisticsTimer;
+    quint64 m_reportCount = 0;
+    ZigbeeLatencyHistogram m_reportLatency;
+    ZigbeeLatencyHistogram m_criticalReportLatency;
+
+    ZigbeeNetworkInfo m_networkInfo;
+    QHash<quint64, ZigbeeNodeInfo> m_nodes;
+    ZigbeeTopology m_topology;
+
+private slots:
+    void onNetworkInfoChanged(const ZigbeeNetworkInfo &networkInfo);
+    void onNodeAdded(const ZigbeeNodeInfo &node);
+    void onNodeInterviewed(const ZigbeeNodeInfo &node);
+    void onNodeRemoved(quint64 ieeeAddress);
+    void onNodeConnectedChanged(quint64 ieeeAddress, bool connected);
+    void onReportsAvailable();
+    void onDeferredReportsRetry();
+    void onNeighborTableReceived(quint16 shortAddress, const QList<ZigbeeNeighbor> &neighbors);
+    void onCommandStatisticsTaken(double waitTimeMedian, double waitTime95);
+
+private:
+    // Returns the number of reports handled, with deferUnknown it stops at the first unknown node
+    int dispatchReports(const ZigbeeAttributeReport *reports, const QByteArray *longValues, int count, bool critical, bool deferUnknown);
+};
+
+#endif // ZIGBEENETWORKTHREAD_H
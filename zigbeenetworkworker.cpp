@@ -0,0 +1,279 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeenetworkworker.h"
+#include "extern-plugininfo.h"
+
+#include <QTimer>
+#include <cstring>
+
+ZigbeeNetworkWorker::ZigbeeNetworkWorker(ZigbeeReportQueue *criticalQueue, ZigbeeReportQueue *bulkQueue, QAtomicInt *pendingCommands, QObject *parent) :
+    QObject(parent),
+    m_criticalQueue(criticalQueue),
+    m_bulkQueue(bulkQueue),
+    m_pendingCommands(pendingCommands)
+{
+    m_commandScheduler = new ZigbeeCommandScheduler(this);
+    connect(m_commandScheduler, &ZigbeeCommandScheduler::commandFinished, this, [this](){
+        m_pendingCommands->deref();
+    });
+}
+
+void ZigbeeNetworkWorker::setSerialCapture(const QString &captureFileName)
+{
+    m_captureFileName = captureFileName;
+}
+
+void ZigbeeNetworkWorker::setSerialReplay(const QString &replayFileName, bool realTime)
+{
+    m_replayFileName = replayFileName;
+    m_replayRealTime = realTime;
+}
+
+void ZigbeeNetworkWorker::startNetwork(const QString &serialPortName, qint32 baudrate, const QString &settingsFileName)
+{
+    // The network manager talks to the proxy pseudo terminal instead of the serial port
+    QString portName = serialPortName;
+    if (!m_replayFileName.isEmpty() || !m_captureFileName.isEmpty()) {
+        m_serialProxy = new ZigbeeSerialProxy(this);
+        bool started = m_replayFileName.isEmpty() ? m_serialProxy->startCapture(serialPortName, baudrate, m_captureFileName)
+                                                  : m_serialProxy->startReplay(m_replayFileName, m_replayRealTime);
+        if (started) {
+            portName = m_serialProxy->portName();
+        } else {
+            qCWarning(dcZigbee()) << "Could not start serial capture or replay, using" << serialPortName << "directly";
+            delete m_serialProxy;
+            m_serialProxy = nullptr;
+        }
+    }
+
+    // Created here so the serial port lives in the network thread
+    m_networkManager = new ZigbeeNetworkManager(this);
+    m_networkManager->setSerialPortName(portName);
+    m_networkManager->setSerialBaudrate(baudrate);
+    m_networkManager->setSettingsFileName(settingsFileName);
+
+    connect(m_networkManager, &ZigbeeNetworkManager::stateChanged, this, &ZigbeeNetworkWorker::onStateChanged);
+    connect(m_networkManager, &ZigbeeNetworkManager::channelChanged, this, &ZigbeeNetworkWorker::updateNetworkInfo);
+    connect(m_networkManager, &ZigbeeNetworkManager::extendedPanIdChanged, this, &ZigbeeNetworkWorker::updateNetworkInfo);
+    connect(m_networkManager, &ZigbeeNetworkManager::permitJoiningChanged, this, &ZigbeeNetworkWorker::updateNetworkInfo);
+    connect(m_networkManager, &ZigbeeNetworkManager::nodeAdded, this, &ZigbeeNetworkWorker::addNode);
+    connect(m_networkManager, &ZigbeeNetworkManager::nodeRemoved, this, &ZigbeeNetworkWorker::removeNode);
+
+    m_nodeInterviewer = new ZigbeeNodeInterviewer(m_networkManager, m_commandScheduler, m_pendingCommands, this);
+    connect(m_nodeInterviewer, &ZigbeeNodeInterviewer::nodeInterviewed, this, [this](ZigbeeNode *node){
+        emit nodeInterviewed(nodeInfo(node));
+    });
+
+    m_topologyCrawler = new ZigbeeTopologyCrawler(m_networkManager, m_commandScheduler, m_pendingCommands, this);
+    connect(m_topologyCrawler, &ZigbeeTopologyCrawler::neighborTableReceived, this, &ZigbeeNetworkWorker::neighborTableReceived);
+
+    // Links change slowly, the topology gets refreshed once an hour
+    m_topologyTimer = new QTimer(this);
+    m_topologyTimer->setInterval(60 * 60 * 1000);
+    connect(m_topologyTimer, &QTimer::timeout, this, &ZigbeeNetworkWorker::crawlTopology);
+
+    m_networkManager->startNetwork();
+}
+
+// Merge keys of the commands where only the latest one matters
+enum CommandMergeKey {
+    MergeKeyNone,
+    MergeKeyPermitJoining,
+    MergeKeyLinkQuality
+};
+
+void ZigbeeNetworkWorker::setPermitJoining(bool permitJoining, int priority)
+{
+    m_commandScheduler->enqueue(static_cast<ZigbeeCommandScheduler::Priority>(priority), 0x0000, MergeKeyPermitJoining, [this, permitJoining]() -> ZigbeeInterfaceReply * {
+        m_networkManager->setPermitJoining(permitJoining);
+        return nullptr;
+    });
+}
+
+void ZigbeeNetworkWorker::factoryResetNetwork(int priority)
+{
+    m_commandScheduler->enqueue(static_cast<ZigbeeCommandScheduler::Priority>(priority), 0x0000, MergeKeyNone, [this]() -> ZigbeeInterfaceReply * {
+        m_networkManager->factoryResetNetwork();
+        return nullptr;
+    });
+}
+
+void ZigbeeNetworkWorker::requestLinkQuality(quint16 shortAddress, int priority)
+{
+    m_commandScheduler->enqueue(static_cast<ZigbeeCommandScheduler::Priority>(priority), shortAddress, MergeKeyLinkQuality, [this, shortAddress]() -> ZigbeeInterfaceReply * {
+        return m_networkManager->controller()->commandRequestLinkQuality(shortAddress);
+    });
+}
+
+void ZigbeeNetworkWorker::crawlTopology()
+{
+    if (m_networkManager->state() != ZigbeeNetwork::StateRunning)
+        return;
+
+    m_topologyCrawler->start();
+}
+
+void ZigbeeNetworkWorker::takeCommandStatistics()
+{
+    double waitTimeMedian = m_commandScheduler->waitTimeMedian();
+    double waitTime95 = m_commandScheduler->waitTime95();
+    m_commandScheduler->resetStatistics();
+    emit commandStatisticsTaken(waitTimeMedian, waitTime95);
+}
+
+ZigbeeNodeInfo ZigbeeNetworkWorker::nodeInfo(ZigbeeNode *node)
+{
+    ZigbeeNodeInfo info;
+    info.ieeeAddress = node->extendedAddress().toUInt64();
+    info.shortAddress = node->shortAddress();
+    info.connected = node->connected();
+
+    foreach (ZigbeeCluster *cluster, node->inputClusters())
+        info.inputClusters.append(static_cast<quint16>(cluster->clusterId()));
+
+    foreach (ZigbeeCluster *cluster, node->outputClusters()) {
+        quint16 clusterId = static_cast<quint16>(cluster->clusterId());
+        info.outputClusters.append(clusterId);
+        foreach (const ZigbeeClusterAttribute &attribute, cluster->attributes()) {
+            info.attributes.insert(static_cast<quint32>(clusterId) << 16 | attribute.id(), attribute.data());
+        }
+    }
+
+    return info;
+}
+
+void ZigbeeNetworkWorker::onStateChanged()
+{
+    // Publish the nodes first, so the plugin knows all of them once it sees the network running
+    if (m_networkManager->state() == ZigbeeNetwork::StateRunning) {
+        foreach (ZigbeeNode *node, m_networkManager->nodes()) {
+            addNode(node);
+        }
+        m_topologyTimer->start();
+        crawlTopology();
+    } else {
+        m_topologyTimer->stop();
+    }
+
+    updateNetworkInfo();
+}
+
+void ZigbeeNetworkWorker::updateNetworkInfo()
+{
+    ZigbeeNetworkInfo networkInfo;
+    networkInfo.state = m_networkManager->state();
+    networkInfo.firmwareVersion = m_networkManager->controllerFirmwareVersion();
+    networkInfo.extendedPanId = m_networkManager->extendedPanId();
+    networkInfo.channel = m_networkManager->channel();
+    networkInfo.permitJoining = m_networkManager->permitJoining();
+    if (m_networkManager->coordinatorNode()) {
+        networkInfo.coordinatorIeeeAddress = m_networkManager->coordinatorNode()->extendedAddress().toUInt64();
+    }
+
+    emit networkInfoChanged(networkInfo);
+}
+
+void ZigbeeNetworkWorker::addNode(ZigbeeNode *node)
+{
+    if (m_nodes.contains(node))
+        return;
+
+    quint64 ieeeAddress = node->extendedAddress().toUInt64();
+    m_nodes.insert(node, ieeeAddress);
+
+    connect(node, &ZigbeeNode::connectedChanged, this, [this, ieeeAddress](bool connected){
+        emit nodeConnectedChanged(ieeeAddress, connected);
+    });
+    connect(node, &ZigbeeNode::clusterAttributeChanged, this, [this, ieeeAddress](ZigbeeCluster *cluster, const ZigbeeClusterAttribute &attribute){
+        queueReport(ieeeAddress, static_cast<quint16>(cluster->clusterId()), attribute);
+    });
+
+    emit nodeAdded(nodeInfo(node));
+
+    // Nodes which just joined often don't tell what they are yet
+    if (!ZigbeeNodeInterviewer::isComplete(node)) {
+        m_nodeInterviewer->interview(node);
+    }
+}
+
+bool ZigbeeNetworkWorker::isLatencyCritical(quint16 clusterId)
+{
+    // Somebody is waiting for switches, buttons and motion. All reports of a cluster
+    // take the same lane, so the order of the values of one attribute stays intact.
+    switch (clusterId) {
+    case Zigbee::ClusterIdOnOff:
+    case Zigbee::ClusterIdOccapancySensing:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void ZigbeeNetworkWorker::queueReport(quint64 ieeeAddress, quint16 clusterId, const ZigbeeClusterAttribute &attribute)
+{
+    QByteArray data = attribute.data();
+
+    ZigbeeAttributeReport report;
+    report.ieeeAddress = ieeeAddress;
+    report.timestamp = ZigbeeReportQueue::timestamp();
+    report.clusterId = clusterId;
+    report.attributeId = attribute.id();
+
+    // Long values like strings are rare, they take the same lane next to the report, so the order stays intact
+    ZigbeeReportQueue *queue = isLatencyCritical(clusterId) ? m_criticalQueue : m_bulkQueue;
+    bool queued = false;
+    if (data.size() > ZigbeeAttributeReport::MaxDataLength) {
+        report.length = ZigbeeAttributeReport::LongValueLength;
+        queued = queue->push(report, data);
+    } else {
+        report.length = static_cast<quint8>(data.size());
+        memcpy(report.data, data.constData(), static_cast<size_t>(data.size()));
+        queued = queue->push(report);
+    }
+
+    if (!queued)
+        return;
+
+    if (queue->requestNotification()) {
+        emit reportsAvailable();
+    }
+}
+
+void ZigbeeNetworkWorker::removeNode(ZigbeeNode *node)
+{
+    if (!m_nodes.contains(node))
+        return;
+
+    disconnect(node, nullptr, this, nullptr);
+    m_nodeInterviewer->cancel(node);
+    emit nodeRemoved(m_nodes.take(node));
+}
@@ -0,0 +1,103 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEENETWORKWORKER_H
+#define ZIGBEENETWORKWORKER_H
+
+#include <QHash>
+#include <QObject>
+
+#include "zigbeenodeinfo.h"
+#include "zigbeereportqueue.h"
+#include "zigbeeserialproxy.h"
+#include "zigbeecommandscheduler.h"
+#include "zigbeetopologycrawler.h"
+#include "zigbeenodeinterviewer.h"
+#include "zigbeenetworkmanager.h"
+
+// Owns the ZigbeeNetworkManager inside the network thread. All access to the
+// manager and its nodes happens here, the results leave as plain copies.
+class ZigbeeNetworkWorker : public QObject
+{
+    Q_OBJECT
+public:
+    // Reports of the critical lane get dispatched before the bulk lane
+    explicit ZigbeeNetworkWorker(ZigbeeReportQueue *criticalQueue, ZigbeeReportQueue *bulkQueue, QAtomicInt *pendingCommands, QObject *parent = nullptr);
+
+public slots:
+    void setSerialCapture(const QString &captureFileName);
+    void setSerialReplay(const QString &replayFileName, bool realTime);
+    void startNetwork(const QString &serialPortName, qint32 baudrate, const QString &settingsFileName);
+    void setPermitJoining(bool permitJoining, int priority);
+    void factoryResetNetwork(int priority);
+    void requestLinkQuality(quint16 shortAddress, int priority);
+    void crawlTopology();
+    // Snapshot and reset in one go, answered with commandStatisticsTaken()
+    void takeCommandStatistics();
+
+signals:
+    void networkInfoChanged(const ZigbeeNetworkInfo &networkInfo);
+    void nodeAdded(const ZigbeeNodeInfo &node);
+    void nodeInterviewed(const ZigbeeNodeInfo &node);
+    void nodeRemoved(quint64 ieeeAddress);
+    void nodeConnectedChanged(quint64 ieeeAddress, bool connected);
+    void reportsAvailable();
+    void neighborTableReceived(quint16 shortAddress, const QList<ZigbeeNeighbor> &neighbors);
+    void commandStatisticsTaken(double waitTimeMedian, double waitTime95);
+
+private:
+    ZigbeeNetworkManager *m_networkManager = nullptr;
+    ZigbeeReportQueue *m_criticalQueue = nullptr;
+    ZigbeeReportQueue *m_bulkQueue = nullptr;
+    QAtomicInt *m_pendingCommands = nullptr;
+    ZigbeeCommandScheduler *m_commandScheduler = nullptr;
+    ZigbeeTopologyCrawler *m_topologyCrawler = nullptr;
+    ZigbeeNodeInterviewer *m_nodeInterviewer = nullptr;
+    QTimer *m_topologyTimer = nullptr;
+
+    ZigbeeSerialProxy *m_serialProxy = nullptr;
+    QString m_captureFileName;
+    QString m_replayFileName;
+    bool m_replayRealTime = true;
+    QHash<ZigbeeNode *, quint64> m_nodes;
+
+    static ZigbeeNodeInfo nodeInfo(ZigbeeNode *node);
+    static bool isLatencyCritical(quint16 clusterId);
+    void queueReport(quint64 ieeeAddress, quint16 clusterId, const ZigbeeClusterAttribute &attribute);
+
+private slots:
+    void onStateChanged();
+    void updateNetworkInfo();
+    void addNode(ZigbeeNode *node);
+    void removeNode(ZigbeeNode *node);
+};
+
+#endif // ZIGBEENETWORKWORKER_H
@@ -0,0 +1,108 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEENODEINFO_H
+#define ZIGBEENODEINFO_H
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QByteArray>
+
+#include "zigbeenetwork.h"
+
+// Plain copies of the network and node state. They get passed from the network
+// thread to the plugin, the plugin never touches a ZigbeeNode directly.
+struct ZigbeeNetworkInfo
+{
+    ZigbeeNetwork::State state = ZigbeeNetwork::StateUninitialized;
+    QString firmwareVersion;
+    quint64 extendedPanId = 0;
+    uint channel = 0;
+    bool permitJoining = false;
+    quint64 coordinatorIeeeAddress = 0;
+};
+
+struct ZigbeeNodeInfo
+{
+    quint64 ieeeAddress = 0;
+    quint16 shortAddress = 0;
+    bool connected = false;
+    QList<quint16> inputClusters;
+    QList<quint16> outputClusters;
+
+    // Known output cluster attribute values by cluster id << 16 | attribute id
+    QHash<quint32, QByteArray> attributes;
+
+    bool hasOutputCluster(quint16 clusterId) const {
+        return outputClusters.contains(clusterId);
+    }
+
+    bool hasAttribute(quint16 clusterId, quint16 attributeId) const {
+        return attributes.contains(static_cast<quint32>(clusterId) << 16 | attributeId);
+    }
+
+    QByteArray attribute(quint16 clusterId, quint16 attributeId) const {
+        return attributes.value(static_cast<quint32>(clusterId) << 16 | attributeId);
+    }
+};
+
+// One entry of the neighbor table of a router
+struct ZigbeeNeighbor
+{
+    enum DeviceType {
+        DeviceTypeCoordinator,
+        DeviceTypeRouter,
+        DeviceTypeEndDevice,
+        DeviceTypeUnknown
+    };
+
+    enum Relationship {
+        RelationshipParent,
+        RelationshipChild,
+        RelationshipSibling,
+        RelationshipNone
+    };
+
+    quint16 shortAddress = 0;
+    quint64 ieeeAddress = 0;
+    quint8 depth = 0;
+    quint8 linkQuality = 0;
+    DeviceType deviceType = DeviceTypeUnknown;
+    Relationship relationship = RelationshipNone;
+    bool rxOnWhenIdle = false;
+};
+
+Q_DECLARE_METATYPE(ZigbeeNetworkInfo)
+Q_DECLARE_METATYPE(ZigbeeNodeInfo)
+Q_DECLARE_METATYPE(ZigbeeNeighbor)
+
+#endif // ZIGBEENODEINFO_H
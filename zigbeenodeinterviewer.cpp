@@ -0,0 +1,218 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeenodeinterviewer.h"
+#include "zigbeenetworkmanager.h"
+#include "extern-plugininfo.h"
+
+#include <QTimer>
+#include <QDataStream>
+
+ZigbeeNodeInterviewer::ZigbeeNodeInterviewer(ZigbeeNetworkManager *networkManager, ZigbeeCommandScheduler *commandScheduler, QAtomicInt *pendingCommands, QObject *parent) :
+    QObject(parent),
+    m_networkManager(networkManager),
+    m_commandScheduler(commandScheduler),
+    m_pendingCommands(pendingCommands)
+{
+
+}
+
+bool ZigbeeNodeInterviewer::isComplete(ZigbeeNode *node)
+{
+    return basicCluster(node) && !missingAttributes(node).contains(Zigbee::ClusterAttributeBasicModelIdentifier);
+}
+
+void ZigbeeNodeInterviewer::interview(ZigbeeNode *node)
+{
+    if (m_attempts.contains(node))
+        return;
+
+    m_attempts.insert(node, 0);
+    m_waiting.append(node);
+    startNext();
+}
+
+void ZigbeeNodeInterviewer::cancel(ZigbeeNode *node)
+{
+    QSharedPointer<bool> done = m_done.take(node);
+    if (done)
+        *done = true;
+
+    m_attempts.remove(node);
+    m_waiting.removeAll(node);
+    m_active.remove(node);
+    startNext();
+}
+
+ZigbeeCluster *ZigbeeNodeInterviewer::basicCluster(ZigbeeNode *node)
+{
+    foreach (ZigbeeCluster *cluster, node->outputClusters()) {
+        if (cluster->clusterId() == Zigbee::ClusterIdBasic) {
+            return cluster;
+        }
+    }
+    return nullptr;
+}
+
+QList<quint16> ZigbeeNodeInterviewer::missingAttributes(ZigbeeNode *node)
+{
+    // The model identifier goes first, the reply carries the response of the first attribute
+    QList<quint16> attributeIds = {
+        Zigbee::ClusterAttributeBasicModelIdentifier,
+        Zigbee::ClusterAttributeBasicManufacturerName
+    };
+
+    ZigbeeCluster *cluster = basicCluster(node);
+    if (cluster) {
+        foreach (const ZigbeeClusterAttribute &attribute, cluster->attributes()) {
+            attributeIds.removeAll(attribute.id());
+        }
+    }
+    return attributeIds;
+}
+
+bool ZigbeeNodeInterviewer::isModelUnsupported(ZigbeeInterfaceReply *reply)
+{
+    // Read attribute response: sequence number, source address, endpoint, cluster id,
+    // attribute id and status
+    QDataStream stream(reply->additionalMessage().data());
+    quint8 sequenceNumber = 0; quint16 sourceAddress = 0; quint8 endpoint = 0; quint16 clusterId = 0; quint16 attributeId = 0; quint8 status = 0;
+    stream >> sequenceNumber >> sourceAddress >> endpoint >> clusterId >> attributeId >> status;
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    return clusterId == Zigbee::ClusterIdBasic && attributeId == Zigbee::ClusterAttributeBasicModelIdentifier && status == statusUnsupportedAttribute;
+}
+
+void ZigbeeNodeInterviewer::startNext()
+{
+    while (m_active.count() < maxConcurrent && !m_waiting.isEmpty()) {
+        readAttributes(m_waiting.takeFirst());
+    }
+}
+
+void ZigbeeNodeInterviewer::readAttributes(ZigbeeNode *node)
+{
+    // The values may have arrived with a late response or a report meanwhile
+    if (isComplete(node)) {
+        finishRead(node, true);
+        return;
+    }
+
+    ZigbeeCluster *cluster = basicCluster(node);
+    if (!cluster) {
+        // The library is still reading the descriptors
+        finishRead(node, false);
+        return;
+    }
+
+    m_active.insert(node);
+    m_pendingCommands->ref();
+
+    // Whichever comes first, the reply or the timeout
+    QSharedPointer<bool> done(new bool(false));
+    m_done.insert(node, done);
+    QTimer::singleShot(requestTimeout, this, [this, node, done](){
+        if (*done)
+            return;
+
+        *done = true;
+        finishRead(node, false);
+    });
+
+    QList<quint16> attributeIds = missingAttributes(node);
+    quint16 shortAddress = node->shortAddress();
+    m_commandScheduler->enqueue(ZigbeeCommandScheduler::PriorityRule, shortAddress, 0, [this, node, cluster, shortAddress, attributeIds, done]() -> ZigbeeInterfaceReply * {
+        // Removed from the network while waiting in the queue
+        if (*done || !m_active.contains(node))
+            return nullptr;
+
+        // The Basic cluster is on the first endpoint of all supported devices
+        ZigbeeInterfaceReply *reply = m_networkManager->controller()->commandReadAttributeRequest(0x02, shortAddress, 0x01, 0x01, cluster, attributeIds);
+        connect(reply, &ZigbeeInterfaceReply::finished, this, [this, node, reply, done](){
+            if (*done)
+                return;
+
+            *done = true;
+            if (reply->status() != ZigbeeInterfaceReply::StatusSuccess) {
+                finishRead(node, false);
+                return;
+            }
+
+            // Reading it again would not change the answer, sleepy devices would only be woken up for nothing
+            if (isModelUnsupported(reply)) {
+                qCDebug(dcZigbee()) << node->extendedAddress().toString() << "does not support the model identifier";
+                finishRead(node, true);
+                return;
+            }
+
+            finishRead(node, isComplete(node));
+        });
+        return reply;
+    });
+}
+
+void ZigbeeNodeInterviewer::finishRead(ZigbeeNode *node, bool success)
+{
+    m_done.remove(node);
+    m_active.remove(node);
+    if (!m_attempts.contains(node)) {
+        startNext();
+        return;
+    }
+
+    if (success) {
+        m_attempts.remove(node);
+        emit nodeInterviewed(node);
+        startNext();
+        return;
+    }
+
+    int attempt = ++m_attempts[node];
+    if (attempt >= maxAttempts) {
+        qCWarning(dcZigbee()) << "Giving up reading the Basic cluster of" << node->extendedAddress().toString();
+        m_attempts.remove(node);
+        startNext();
+        return;
+    }
+
+    // The slot is free while waiting, other nodes can go on meanwhile
+    int delay = retryDelay << (attempt - 1);
+    qCDebug(dcZigbee()) << "Reading the Basic cluster of" << node->extendedAddress().toString() << "failed, retry in" << delay << "ms";
+    QTimer::singleShot(delay, this, [this, node](){
+        if (!m_attempts.contains(node))
+            return;
+
+        m_waiting.append(node);
+        startNext();
+    });
+    startNext();
+}
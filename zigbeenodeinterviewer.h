@@ -0,0 +1,95 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEENODEINTERVIEWER_H
+#define ZIGBEENODEINTERVIEWER_H
+
+#include <QSet>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+
+#include "zigbeecommandscheduler.h"
+
+class ZigbeeNode;
+class ZigbeeCluster;
+class ZigbeeNetworkManager;
+class ZigbeeInterfaceReply;
+
+// Reads the Basic cluster attributes needed to classify a node, for all nodes missing
+// them. The model identifier is required, the manufacturer name is read along if missing.
+// Interviews run in parallel up to a limit, all missing attributes of a node get read with
+// a single request, failed reads are retried with exponential backoff. A node reporting the
+// model identifier as unsupported counts as interviewed. Lives in the network thread.
+class ZigbeeNodeInterviewer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ZigbeeNodeInterviewer(ZigbeeNetworkManager *networkManager, ZigbeeCommandScheduler *commandScheduler, QAtomicInt *pendingCommands, QObject *parent = nullptr);
+
+    static bool isComplete(ZigbeeNode *node);
+
+    void interview(ZigbeeNode *node);
+    void cancel(ZigbeeNode *node);
+
+signals:
+    void nodeInterviewed(ZigbeeNode *node);
+
+private:
+    static const int maxConcurrent = 4;
+    static const int maxAttempts = 5;
+    static const int retryDelay = 1000;
+    static const int requestTimeout = 15000;
+    static const quint8 statusUnsupportedAttribute = 0x86;
+
+    ZigbeeNetworkManager *m_networkManager = nullptr;
+    ZigbeeCommandScheduler *m_commandScheduler = nullptr;
+    QAtomicInt *m_pendingCommands = nullptr;
+
+    // All nodes being interviewed by the number of failed attempts
+    QHash<ZigbeeNode *, int> m_attempts;
+    QList<ZigbeeNode *> m_waiting;
+    QSet<ZigbeeNode *> m_active;
+    // Set once the reply or the timeout of the running request got handled, or the node got
+    // cancelled. Late callbacks must not touch the node anymore, it may be gone already.
+    QHash<ZigbeeNode *, QSharedPointer<bool>> m_done;
+
+    static ZigbeeCluster *basicCluster(ZigbeeNode *node);
+    static QList<quint16> missingAttributes(ZigbeeNode *node);
+    static bool isModelUnsupported(ZigbeeInterfaceReply *reply);
+
+    void startNext();
+    void readAttributes(ZigbeeNode *node);
+    void finishRead(ZigbeeNode *node, bool success);
+};
+
+#endif // ZIGBEENODEINTERVIEWER_H
@@ -0,0 +1,260 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeenodesnapshot.h"
+#include "extern-plugininfo.h"
+
+#include <QtEndian>
+#include <cstring>
+#include <QSaveFile>
+#include <QDataStream>
+
+// File layout, all values little endian:
+//   header:    "ZBSN", version (u16), node count (u32)
+//   node:      ieee address (u64), short address (u16), input cluster count (u8),
+//              output cluster count (u8), cluster ids (u16 each), attribute count (u16)
+//   attribute: cluster id (u16), attribute id (u16), length (u16), raw data
+static const char snapshotMagic[] = "ZBSN";
+static const quint16 snapshotVersion = 1;
+
+ZigbeeNodeSnapshot::ZigbeeNodeSnapshot(const QString &fileName, QObject *parent) :
+    QObject(parent),
+    m_file(fileName)
+{
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setInterval(5 * 60 * 1000);
+    m_saveTimer->setSingleShot(true);
+    connect(m_saveTimer, &QTimer::timeout, this, &ZigbeeNodeSnapshot::save);
+}
+
+ZigbeeNodeSnapshot::~ZigbeeNodeSnapshot()
+{
+    if (m_saveTimer->isActive()) {
+        save();
+    }
+
+    // The attribute values might still point into the mapping
+    m_nodes.clear();
+    unload();
+}
+
+bool ZigbeeNodeSnapshot::load()
+{
+    if (!m_file.exists())
+        return false;
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qCWarning(dcZigbee()) << "Could not open node snapshot" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    // The file stays open as long as it is mapped, closing it would unmap it
+    qint64 size = m_file.size();
+    m_map = m_file.map(0, size);
+    if (!m_map) {
+        qCWarning(dcZigbee()) << "Could not map node snapshot" << m_file.fileName() << m_file.errorString();
+        unload();
+        return false;
+    }
+
+    const uchar *data = m_map;
+    const uchar *end = m_map + size;
+    if (size < 10 || memcmp(data, snapshotMagic, 4) != 0 || qFromLittleEndian<quint16>(data + 4) != snapshotVersion) {
+        qCWarning(dcZigbee()) << "Ignoring invalid node snapshot" << m_file.fileName();
+        unload();
+        return false;
+    }
+
+    quint32 nodeCount = qFromLittleEndian<quint32>(data + 6);
+    data += 10;
+
+    QHash<quint64, NodeEntry> nodes;
+    for (quint32 i = 0; i < nodeCount; i++) {
+        if (end - data < 12)
+            break;
+
+        quint64 ieeeAddress = qFromLittleEndian<quint64>(data);
+        NodeEntry entry;
+        entry.shortAddress = qFromLittleEndian<quint16>(data + 8);
+        int inputClusterCount = data[10];
+        int outputClusterCount = data[11];
+        data += 12;
+
+        if (end - data < (inputClusterCount + outputClusterCount) * 2 + 2)
+            break;
+
+        for (int j = 0; j < inputClusterCount; j++, data += 2)
+            entry.inputClusters.append(qFromLittleEndian<quint16>(data));
+
+        for (int j = 0; j < outputClusterCount; j++, data += 2)
+            entry.outputClusters.append(qFromLittleEndian<quint16>(data));
+
+        quint16 attributeCount = qFromLittleEndian<quint16>(data);
+        data += 2;
+
+        for (int j = 0; j < attributeCount && end - data >= 6; j++) {
+            quint16 clusterId = qFromLittleEndian<quint16>(data);
+            quint16 attributeId = qFromLittleEndian<quint16>(data + 2);
+            quint16 length = qFromLittleEndian<quint16>(data + 4);
+            data += 6;
+            if (end - data < length)
+                break;
+
+            // No copy, the value points into the mapping
+            entry.attributes.insert(static_cast<quint32>(clusterId) << 16 | attributeId, QByteArray::fromRawData(reinterpret_cast<const char *>(data), length));
+            data += length;
+        }
+
+        nodes.insert(ieeeAddress, entry);
+    }
+
+    m_nodes = nodes;
+    qCDebug(dcZigbee()) << "Loaded node snapshot with" << m_nodes.count() << "nodes";
+    return true;
+}
+
+bool ZigbeeNodeSnapshot::save()
+{
+    m_saveTimer->stop();
+
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData(snapshotMagic, 4);
+    stream << snapshotVersion << static_cast<quint32>(m_nodes.count());
+
+    for (QHash<quint64, NodeEntry>::const_iterator it = m_nodes.constBegin(); it != m_nodes.constEnd(); ++it) {
+        const NodeEntry &entry = it.value();
+        stream << it.key() << entry.shortAddress;
+        stream << static_cast<quint8>(entry.inputClusters.count()) << static_cast<quint8>(entry.outputClusters.count());
+        foreach (quint16 clusterId, entry.inputClusters)
+            stream << clusterId;
+
+        foreach (quint16 clusterId, entry.outputClusters)
+            stream << clusterId;
+
+        stream << static_cast<quint16>(entry.attributes.count());
+        for (QHash<quint32, QByteArray>::const_iterator attributeIt = entry.attributes.constBegin(); attributeIt != entry.attributes.constEnd(); ++attributeIt) {
+            stream << static_cast<quint16>(attributeIt.key() >> 16) << static_cast<quint16>(attributeIt.key() & 0xffff);
+            stream << static_cast<quint16>(attributeIt.value().size());
+            stream.writeRawData(attributeIt.value().constData(), attributeIt.value().size());
+        }
+    }
+
+    // The current mapping stays valid, the new file replaces the old one atomically
+    QSaveFile file(m_file.fileName());
+    if (!file.open(QIODevice::WriteOnly) || file.write(buffer) != buffer.size() || !file.commit()) {
+        qCWarning(dcZigbee()) << "Could not write node snapshot" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    qCDebug(dcZigbee()) << "Saved node snapshot with" << m_nodes.count() << "nodes";
+    return true;
+}
+
+bool ZigbeeNodeSnapshot::hasNode(quint64 ieeeAddress) const
+{
+    return m_nodes.contains(ieeeAddress);
+}
+
+ZigbeeNodeInfo ZigbeeNodeSnapshot::node(quint64 ieeeAddress) const
+{
+    ZigbeeNodeInfo node;
+    QHash<quint64, NodeEntry>::const_iterator it = m_nodes.constFind(ieeeAddress);
+    if (it == m_nodes.constEnd())
+        return node;
+
+    // Not connected until the network says so
+    node.ieeeAddress = ieeeAddress;
+    node.shortAddress = it.value().shortAddress;
+    node.inputClusters = it.value().inputClusters;
+    node.outputClusters = it.value().outputClusters;
+
+    // Copied, the mapping goes away with the snapshot
+    for (QHash<quint32, QByteArray>::const_iterator attributeIt = it.value().attributes.constBegin(); attributeIt != it.value().attributes.constEnd(); ++attributeIt) {
+        node.attributes.insert(attributeIt.key(), QByteArray(attributeIt.value().constData(), attributeIt.value().size()));
+    }
+    return node;
+}
+
+QByteArray ZigbeeNodeSnapshot::attribute(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId) const
+{
+    QHash<quint64, NodeEntry>::const_iterator it = m_nodes.constFind(ieeeAddress);
+    if (it == m_nodes.constEnd())
+        return QByteArray();
+
+    return it.value().attributes.value(static_cast<quint32>(clusterId) << 16 | attributeId);
+}
+
+void ZigbeeNodeSnapshot::updateNode(quint64 ieeeAddress, quint16 shortAddress, const QList<quint16> &inputClusters, const QList<quint16> &outputClusters)
+{
+    NodeEntry &entry = m_nodes[ieeeAddress];
+    if (entry.shortAddress == shortAddress && entry.inputClusters == inputClusters && entry.outputClusters == outputClusters)
+        return;
+
+    entry.shortAddress = shortAddress;
+    entry.inputClusters = inputClusters;
+    entry.outputClusters = outputClusters;
+    setDirty();
+}
+
+void ZigbeeNodeSnapshot::updateAttribute(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data)
+{
+    QByteArray &value = m_nodes[ieeeAddress].attributes[static_cast<quint32>(clusterId) << 16 | attributeId];
+    if (value == data)
+        return;
+
+    value = data;
+    setDirty();
+}
+
+void ZigbeeNodeSnapshot::removeNode(quint64 ieeeAddress)
+{
+    if (m_nodes.remove(ieeeAddress) > 0) {
+        setDirty();
+    }
+}
+
+void ZigbeeNodeSnapshot::unload()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+}
+
+void ZigbeeNodeSnapshot::setDirty()
+{
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
@@ -0,0 +1,85 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEENODESNAPSHOT_H
+#define ZIGBEENODESNAPSHOT_H
+
+#include <QFile>
+#include <QHash>
+#include <QTimer>
+#include <QObject>
+
+#include "zigbeenodeinfo.h"
+
+// Binary snapshot of the known nodes, their clusters and the last reported raw
+// attribute values, so things come up with their last known state after a restart.
+//
+// The file gets memory mapped on load and the attribute values point into the
+// mapping until they get updated. Changes are written back a while after they
+// happened and when the snapshot gets destroyed.
+class ZigbeeNodeSnapshot : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ZigbeeNodeSnapshot(const QString &fileName, QObject *parent = nullptr);
+    ~ZigbeeNodeSnapshot() override;
+
+    bool load();
+    bool save();
+
+    bool hasNode(quint64 ieeeAddress) const;
+    // The last known state of the node, as disconnected node
+    ZigbeeNodeInfo node(quint64 ieeeAddress) const;
+    QByteArray attribute(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId) const;
+
+    void updateNode(quint64 ieeeAddress, quint16 shortAddress, const QList<quint16> &inputClusters, const QList<quint16> &outputClusters);
+    void updateAttribute(quint64 ieeeAddress, quint16 clusterId, quint16 attributeId, const QByteArray &data);
+    void removeNode(quint64 ieeeAddress);
+
+private:
+    struct NodeEntry {
+        quint16 shortAddress = 0;
+        QList<quint16> inputClusters;
+        QList<quint16> outputClusters;
+        QHash<quint32, QByteArray> attributes;
+    };
+
+    QFile m_file;
+    uchar *m_map = nullptr;
+    QTimer *m_saveTimer = nullptr;
+
+    QHash<quint64, NodeEntry> m_nodes;
+
+    void unload();
+    void setDirty();
+};
+
+#endif // ZIGBEENODESNAPSHOT_H
@@ -0,0 +1,130 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeereportfilter.h"
+
+#include <QtMath>
+
+ZigbeeReportFilter::ZigbeeReportFilter(ZigbeeTimerWheel *timerWheel, Publisher publisher) :
+    m_timerWheel(timerWheel),
+    m_publisher(publisher)
+{
+    m_clock.start();
+}
+
+void ZigbeeReportFilter::resize(int count)
+{
+    m_deadbands.resize(count);
+    m_minimumIntervals.resize(count);
+    m_published.resize(count);
+    m_publishedValues.resize(count);
+    m_publishedTimestamps.resize(count);
+    m_pendingValues.resize(count);
+    m_flushTimers.resize(count);
+}
+
+void ZigbeeReportFilter::reset(int deviceId)
+{
+    m_timerWheel->cancel(m_flushTimers.at(deviceId));
+    m_flushTimers[deviceId] = 0;
+    m_deadbands[deviceId] = 0;
+    m_minimumIntervals[deviceId] = 0;
+    m_published[deviceId] = false;
+    m_publishedValues[deviceId] = 0;
+    m_publishedTimestamps[deviceId] = 0;
+    m_pendingValues[deviceId] = 0;
+}
+
+void ZigbeeReportFilter::configure(int deviceId, double deadband, int minimumInterval)
+{
+    m_deadbands[deviceId] = qMax(0.0, deadband);
+    m_minimumIntervals[deviceId] = qMax(0, minimumInterval);
+}
+
+void ZigbeeReportFilter::submit(int deviceId, double value)
+{
+    if (!m_published.at(deviceId)) {
+        publish(deviceId, value);
+        return;
+    }
+
+    // A flush is pending already, it publishes whatever got reported last
+    if (m_timerWheel->isActive(m_flushTimers.at(deviceId))) {
+        m_pendingValues[deviceId] = value;
+        m_suppressedCount++;
+        return;
+    }
+
+    double publishedValue = m_publishedValues.at(deviceId);
+    if (qAbs(value - publishedValue) < m_deadbands.at(deviceId) || qFuzzyCompare(value, publishedValue)) {
+        m_suppressedCount++;
+        return;
+    }
+
+    qint64 remaining = m_publishedTimestamps.at(deviceId) + m_minimumIntervals.at(deviceId) - m_clock.elapsed();
+    if (remaining <= 0) {
+        publish(deviceId, value);
+        return;
+    }
+
+    // Too early, keep the latest value for the trailing edge
+    m_pendingValues[deviceId] = value;
+    m_flushTimers[deviceId] = m_timerWheel->start(static_cast<int>(remaining), [this, deviceId](){
+        flush(deviceId);
+    });
+}
+
+quint64 ZigbeeReportFilter::suppressedCount() const
+{
+    return m_suppressedCount;
+}
+
+void ZigbeeReportFilter::flush(int deviceId)
+{
+    m_flushTimers[deviceId] = 0;
+
+    // The latest value went back to the published one meanwhile
+    if (qFuzzyCompare(m_pendingValues.at(deviceId), m_publishedValues.at(deviceId))) {
+        m_suppressedCount++;
+        return;
+    }
+
+    publish(deviceId, m_pendingValues.at(deviceId));
+}
+
+void ZigbeeReportFilter::publish(int deviceId, double value)
+{
+    m_timerWheel->cancel(m_flushTimers.at(deviceId));
+    m_published[deviceId] = true;
+    m_publishedValues[deviceId] = value;
+    m_publishedTimestamps[deviceId] = m_clock.elapsed();
+    m_publisher(deviceId, value);
+}
@@ -0,0 +1,83 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEEREPORTFILTER_H
+#define ZIGBEEREPORTFILTER_H
+
+#include <QVector>
+#include <QElapsedTimer>
+
+#include <functional>
+
+#include "zigbeetimerwheel.h"
+
+// Coalesces the reported values of one state type before they get published.
+//
+// Values within the absolute deadband around the last published value are dropped.
+// Values arriving faster than the minimum interval are held back and the latest
+// reported value gets flushed once the interval has passed.
+class ZigbeeReportFilter
+{
+public:
+    typedef std::function<void(int deviceId, double value)> Publisher;
+
+    explicit ZigbeeReportFilter(ZigbeeTimerWheel *timerWheel, Publisher publisher);
+
+    void resize(int count);
+    void reset(int deviceId);
+    void configure(int deviceId, double deadband, int minimumInterval);
+
+    void submit(int deviceId, double value);
+
+    // Number of reported values which never got published
+    quint64 suppressedCount() const;
+
+private:
+    ZigbeeTimerWheel *m_timerWheel = nullptr;
+    Publisher m_publisher;
+    QElapsedTimer m_clock;
+
+    QVector<double> m_deadbands;
+    QVector<int> m_minimumIntervals;
+
+    QVector<bool> m_published;
+    QVector<double> m_publishedValues;
+    QVector<qint64> m_publishedTimestamps;
+    QVector<double> m_pendingValues;
+    QVector<ZigbeeTimerWheel::TimerId> m_flushTimers;
+
+    quint64 m_suppressedCount = 0;
+
+    void publish(int deviceId, double value);
+    void flush(int deviceId);
+};
+
+#endif // ZIGBEEREPORTFILTER_H
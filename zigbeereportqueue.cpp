@@ -0,0 +1,116 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeereportqueue.h"
+
+#include <chrono>
+
+ZigbeeReportQueue::ZigbeeReportQueue(int capacity)
+{
+    int size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    m_reports.resize(size);
+    m_buffer = m_reports.data();
+    m_longValues.resize(size);
+    m_mask = static_cast<quint32>(size - 1);
+}
+
+qint64 ZigbeeReportQueue::timestamp()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int ZigbeeReportQueue::capacity() const
+{
+    return m_reports.size();
+}
+
+int ZigbeeReportQueue::count() const
+{
+    return static_cast<int>(m_tail.loadAcquire() - m_head.loadAcquire());
+}
+
+quint32 ZigbeeReportQueue::overflowCount() const
+{
+    return m_overflowCount.loadAcquire();
+}
+
+bool ZigbeeReportQueue::push(const ZigbeeAttributeReport &report, const QByteArray &longValue)
+{
+    quint32 tail = m_tail.loadAcquire();
+    if (tail - m_head.loadAcquire() > m_mask) {
+        m_overflowCount.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    // The slot is owned by the producer until the tail moves past it
+    m_buffer[tail & m_mask] = report;
+    if (report.length == ZigbeeAttributeReport::LongValueLength) {
+        m_longValues[static_cast<int>(tail & m_mask)] = longValue;
+    }
+    m_tail.storeRelease(tail + 1);
+    return true;
+}
+
+bool ZigbeeReportQueue::requestNotification()
+{
+    return m_notified.testAndSetOrdered(0, 1);
+}
+
+int ZigbeeReportQueue::pop(ZigbeeAttributeReport *reports, int maxCount, QByteArray *longValues)
+{
+    quint32 head = m_head.loadAcquire();
+    quint32 available = m_tail.loadAcquire() - head;
+    int count = qMin(static_cast<int>(available), maxCount);
+    for (int i = 0; i < count; i++) {
+        quint32 slot = (head + static_cast<quint32>(i)) & m_mask;
+        reports[i] = m_buffer[slot];
+        if (reports[i].length == ZigbeeAttributeReport::LongValueLength) {
+            // Taken out, so the slot doesn't keep the value alive
+            longValues[i].swap(m_longValues[static_cast<int>(slot)]);
+            m_longValues[static_cast<int>(slot)].clear();
+        }
+    }
+
+    m_head.storeRelease(head + static_cast<quint32>(count));
+    return count;
+}
+
+void ZigbeeReportQueue::clearNotification()
+{
+    // A read-modify-write, so it is ordered against the producer's testAndSet on the same
+    // flag. Either the producer sees the cleared flag and notifies again, or its tail
+    // update is visible to the following pop(). A plain store followed by the load of
+    // the tail could be reordered and lose the wakeup.
+    m_notified.fetchAndStoreOrdered(0);
+}
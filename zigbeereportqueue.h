@@ -0,0 +1,93 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEEREPORTQUEUE_H
+#define ZIGBEEREPORTQUEUE_H
+
+#include <QVector>
+#include <QByteArray>
+#include <QAtomicInteger>
+
+// Fixed size copy of one attribute report. The library does not tell the endpoint
+// of a report, it stays 0 until it does. Longer values like strings travel next to
+// the report as long value, marked with the LongValueLength.
+struct ZigbeeAttributeReport
+{
+    static const int MaxDataLength = 32;
+    static const quint8 LongValueLength = 0xff;
+
+    quint64 ieeeAddress = 0;
+    qint64 timestamp = 0; // ZigbeeReportQueue::timestamp()
+    quint16 clusterId = 0;
+    quint16 attributeId = 0;
+    quint8 endpoint = 0;
+    quint8 length = 0;
+    char data[MaxDataLength];
+};
+
+// Bounded lock free ring of attribute reports between exactly one producer (the network
+// thread) and one consumer (the main thread). Reports which don't fit get dropped and counted.
+class ZigbeeReportQueue
+{
+public:
+    // The capacity gets rounded up to the next power of two
+    explicit ZigbeeReportQueue(int capacity = 1024);
+
+    // Monotonic microseconds, comparable between threads
+    static qint64 timestamp();
+
+    int capacity() const;
+    int count() const;
+    quint32 overflowCount() const;
+
+    // Producer side, the long value is only used for reports marked with the LongValueLength
+    bool push(const ZigbeeAttributeReport &report, const QByteArray &longValue = QByteArray());
+    // Returns true once until the consumer cleared the notification, so a batch needs only one wakeup
+    bool requestNotification();
+
+    // Consumer side, longValues gets the long values at the index of their report
+    int pop(ZigbeeAttributeReport *reports, int maxCount, QByteArray *longValues);
+    void clearNotification();
+
+private:
+    QVector<ZigbeeAttributeReport> m_reports;
+    ZigbeeAttributeReport *m_buffer = nullptr;
+    // Same slots as the reports, owned along with them
+    QVector<QByteArray> m_longValues;
+    quint32 m_mask = 0;
+
+    QAtomicInteger<quint32> m_head;
+    QAtomicInteger<quint32> m_tail;
+    QAtomicInteger<quint32> m_overflowCount;
+    QAtomicInt m_notified;
+};
+
+#endif // ZIGBEEREPORTQUEUE_H
@@ -0,0 +1,145 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeesensorhandler.h"
+#include "integrationpluginzigbee.h"
+#include "extern-plugininfo.h"
+
+#include <QDateTime>
+
+ZigbeeSensorHandler::ZigbeeSensorHandler(IntegrationPluginZigbee *plugin, const ThingClassId &thingClassId, const ParamTypeId &ieeeAddressParamTypeId, const StateTypeId &connectedStateTypeId) :
+    ZigbeeThingHandler(plugin),
+    m_thingClassId(thingClassId),
+    m_ieeeAddressParamTypeId(ieeeAddressParamTypeId),
+    m_connectedStateTypeId(connectedStateTypeId)
+{
+    m_plugin->attributeRouter()->registerConnectedHandler(m_thingClassId, [this](int deviceId, bool connected) {
+        onConnectedChanged(deviceId, connected);
+    });
+}
+
+ThingClassId ZigbeeSensorHandler::thingClassId() const
+{
+    return m_thingClassId;
+}
+
+void ZigbeeSensorHandler::setupThing(ThingSetupInfo *info)
+{
+    Thing *thing = info->thing();
+    qCDebug(dcZigbee()) << "Setup sensor" << thing;
+
+    const ZigbeeNodeInfo *node = findNode(thing, m_ieeeAddressParamTypeId);
+    if (!node) {
+        qCWarning(dcZigbee()) << "Could not find node for this device. The setup failed";
+        return info->finish(Thing::ThingErrorSetupFailed);
+    }
+
+    int deviceId = addDevice(thing);
+    m_ieeeAddresses[deviceId] = node->ieeeAddress;
+    setupDevice(deviceId);
+    m_plugin->attributeRouter()->addNode(*node, thing, deviceId);
+
+    info->finish(Thing::ThingErrorNoError);
+}
+
+void ZigbeeSensorHandler::thingRemoved(Thing *thing)
+{
+    m_plugin->attributeRouter()->removeThing(thing);
+
+    if (!m_deviceIds.contains(thing))
+        return;
+
+    int deviceId = m_deviceIds.take(thing);
+    resetDevice(deviceId);
+    m_things[deviceId] = nullptr;
+    m_freeDeviceIds.append(deviceId);
+}
+
+void ZigbeeSensorHandler::registerAttribute(quint16 clusterId, quint16 attributeId, ZigbeeAttributeRouter::AttributeHandler handler, bool initialize)
+{
+    m_plugin->attributeRouter()->registerAttribute(m_thingClassId, clusterId, attributeId, [this, handler](int deviceId, const QByteArray &data) {
+        m_lastSeen[deviceId] = QDateTime::currentMSecsSinceEpoch();
+        handler(deviceId, data);
+    }, initialize);
+}
+
+void ZigbeeSensorHandler::registerCluster(quint16 clusterId, ZigbeeAttributeRouter::AttributeHandler handler)
+{
+    m_plugin->attributeRouter()->registerCluster(m_thingClassId, clusterId, [this, handler](int deviceId, const QByteArray &data) {
+        m_lastSeen[deviceId] = QDateTime::currentMSecsSinceEpoch();
+        handler(deviceId, data);
+    });
+}
+
+void ZigbeeSensorHandler::resizeDevices(int count)
+{
+    m_things.resize(count);
+    m_connected.resize(count);
+    m_lastSeen.resize(count);
+    m_ieeeAddresses.resize(count);
+}
+
+void ZigbeeSensorHandler::resetDevice(int deviceId)
+{
+    m_connected[deviceId] = false;
+    m_lastSeen[deviceId] = 0;
+    m_ieeeAddresses[deviceId] = 0;
+}
+
+void ZigbeeSensorHandler::setupDevice(int deviceId)
+{
+    Q_UNUSED(deviceId)
+}
+
+int ZigbeeSensorHandler::addDevice(Thing *thing)
+{
+    if (m_deviceIds.contains(thing))
+        return m_deviceIds.value(thing);
+
+    int deviceId = 0;
+    if (!m_freeDeviceIds.isEmpty()) {
+        deviceId = m_freeDeviceIds.takeLast();
+    } else {
+        deviceId = m_things.count();
+        resizeDevices(deviceId + 1);
+    }
+
+    resetDevice(deviceId);
+    m_things[deviceId] = thing;
+    m_deviceIds.insert(thing, deviceId);
+    return deviceId;
+}
+
+void ZigbeeSensorHandler::onConnectedChanged(int deviceId, bool connected)
+{
+    m_connected[deviceId] = connected;
+    m_things.at(deviceId)->setStateValue(m_connectedStateTypeId, connected);
+}
@@ -0,0 +1,81 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEESENSORHANDLER_H
+#define ZIGBEESENSORHANDLER_H
+
+#include <QHash>
+#include <QVector>
+
+#include "zigbeethinghandler.h"
+#include "zigbeeattributerouter.h"
+
+// Thing handler keeping the state of all sensors of one thing class in contiguous
+// arrays indexed by a dense device id. Ids of removed things get reused, subclasses
+// size their own arrays in resizeDevices() and initialize a slot in resetDevice().
+// setupDevice() gets called once the thing got its id, before any value is routed.
+class ZigbeeSensorHandler : public ZigbeeThingHandler
+{
+    Q_OBJECT
+public:
+    explicit ZigbeeSensorHandler(IntegrationPluginZigbee *plugin, const ThingClassId &thingClassId, const ParamTypeId &ieeeAddressParamTypeId, const StateTypeId &connectedStateTypeId);
+
+    ThingClassId thingClassId() const override;
+
+    void setupThing(ThingSetupInfo *info) override;
+    void thingRemoved(Thing *thing) override;
+
+protected:
+    QVector<Thing *> m_things;
+    QVector<bool> m_connected;
+    QVector<qint64> m_lastSeen;
+    QVector<quint64> m_ieeeAddresses;
+
+    void registerAttribute(quint16 clusterId, quint16 attributeId, ZigbeeAttributeRouter::AttributeHandler handler, bool initialize = true);
+    void registerCluster(quint16 clusterId, ZigbeeAttributeRouter::AttributeHandler handler);
+
+    virtual void resizeDevices(int count);
+    virtual void resetDevice(int deviceId);
+    virtual void setupDevice(int deviceId);
+
+private:
+    ThingClassId m_thingClassId;
+    ParamTypeId m_ieeeAddressParamTypeId;
+    StateTypeId m_connectedStateTypeId;
+
+    QHash<Thing *, int> m_deviceIds;
+    QVector<int> m_freeDeviceIds;
+
+    int addDevice(Thing *thing);
+    void onConnectedChanged(int deviceId, bool connected);
+};
+
+#endif // ZIGBEESENSORHANDLER_H
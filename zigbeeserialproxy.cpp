@@ -0,0 +1,359 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeeserialproxy.h"
+#include "extern-plugininfo.h"
+
+#include <QtEndian>
+#include <QDateTime>
+#include <QDataStream>
+
+#include <fcntl.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <termios.h>
+
+static const char captureMagic[] = "ZBCP";
+static const quint16 captureVersion = 1;
+static const int recordHeaderSize = 11;
+// A network manager which doesn't send what the capture expects doesn't get its replies
+static const int replayStallTimeout = 5000;
+
+ZigbeeSerialProxy::ZigbeeSerialProxy(QObject *parent) :
+    QObject(parent)
+{
+
+}
+
+ZigbeeSerialProxy::~ZigbeeSerialProxy()
+{
+    close();
+}
+
+bool ZigbeeSerialProxy::startCapture(const QString &serialPortName, qint32 baudrate, const QString &captureFileName)
+{
+    m_captureFile.setFileName(captureFileName);
+    if (!m_captureFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(dcZigbee()) << "Could not open serial capture file" << captureFileName << m_captureFile.errorString();
+        return false;
+    }
+
+    m_serialPort = new QSerialPort(serialPortName, this);
+    m_serialPort->setBaudRate(baudrate);
+    if (!m_serialPort->open(QIODevice::ReadWrite)) {
+        qCWarning(dcZigbee()) << "Could not open serial port" << serialPortName << m_serialPort->errorString();
+        close();
+        return false;
+    }
+
+    if (!openPseudoTerminal()) {
+        close();
+        return false;
+    }
+
+    if (m_captureFile.size() == 0) {
+        QDataStream stream(&m_captureFile);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream.writeRawData(captureMagic, 4);
+        stream << captureVersion;
+    }
+
+    m_captureClock.start();
+    QByteArray sessionStart;
+    QDataStream stream(&sessionStart, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << QDateTime::currentMSecsSinceEpoch();
+    writeRecord(RecordSession, sessionStart);
+
+    connect(m_serialPort, &QSerialPort::readyRead, this, &ZigbeeSerialProxy::onSerialPortReadyRead);
+    connect(m_serialPort, &QSerialPort::errorOccurred, this, &ZigbeeSerialProxy::onSerialPortError);
+    qCDebug(dcZigbee()) << "Capturing serial traffic of" << serialPortName << "to" << captureFileName << "through" << m_portName;
+    return true;
+}
+
+bool ZigbeeSerialProxy::startReplay(const QString &captureFileName, bool realTime)
+{
+    QFile file(captureFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(dcZigbee()) << "Could not open serial capture file" << captureFileName << file.errorString();
+        return false;
+    }
+
+    m_replayData = file.readAll();
+    if (m_replayData.size() < 6 || !m_replayData.startsWith(captureMagic) || qFromLittleEndian<quint16>(m_replayData.constData() + 4) != captureVersion) {
+        qCWarning(dcZigbee()) << "Invalid serial capture file" << captureFileName;
+        close();
+        return false;
+    }
+
+    if (!openPseudoTerminal()) {
+        close();
+        return false;
+    }
+
+    m_replayPosition = 6;
+    m_replayRealTime = realTime;
+    m_replayTimer = new QTimer(this);
+    m_replayTimer->setSingleShot(true);
+    m_replayTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_replayTimer, &QTimer::timeout, this, &ZigbeeSerialProxy::replayNext);
+    m_replayStallTimer = new QTimer(this);
+    m_replayStallTimer->setSingleShot(true);
+    m_replayStallTimer->setInterval(replayStallTimeout);
+    connect(m_replayStallTimer, &QTimer::timeout, this, &ZigbeeSerialProxy::onReplayStalled);
+
+    qCDebug(dcZigbee()) << "Replaying serial capture" << captureFileName << (realTime ? "in real time" : "as fast as possible") << "through" << m_portName;
+    m_replayClock.start();
+    m_replayTimer->start(0);
+    return true;
+}
+
+QString ZigbeeSerialProxy::portName() const
+{
+    return m_portName;
+}
+
+bool ZigbeeSerialProxy::openPseudoTerminal()
+{
+    m_masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m_masterFd < 0 || grantpt(m_masterFd) != 0 || unlockpt(m_masterFd) != 0) {
+        qCWarning(dcZigbee()) << "Could not create a pseudo terminal" << strerror(errno);
+        return false;
+    }
+
+    fcntl(m_masterFd, F_SETFL, fcntl(m_masterFd, F_GETFL) | O_NONBLOCK);
+    m_portName = QString::fromLocal8Bit(ptsname(m_masterFd));
+
+    // Keep the slave open, otherwise the master hangs up whenever the network manager closes it
+    m_slaveFd = ::open(ptsname(m_masterFd), O_RDWR | O_NOCTTY);
+    if (m_slaveFd < 0) {
+        qCWarning(dcZigbee()) << "Could not open pseudo terminal" << m_portName << strerror(errno);
+        return false;
+    }
+
+    struct termios settings;
+    tcgetattr(m_slaveFd, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(m_slaveFd, TCSANOW, &settings);
+
+    m_readNotifier = new QSocketNotifier(m_masterFd, QSocketNotifier::Read, this);
+    connect(m_readNotifier, &QSocketNotifier::activated, this, &ZigbeeSerialProxy::onMasterReadyRead);
+    m_writeNotifier = new QSocketNotifier(m_masterFd, QSocketNotifier::Write, this);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier, &QSocketNotifier::activated, this, &ZigbeeSerialProxy::onMasterReadyWrite);
+    return true;
+}
+
+void ZigbeeSerialProxy::close()
+{
+    // Leaves the proxy as if it never got started, startCapture() and startReplay() may be tried again
+    delete m_readNotifier;
+    m_readNotifier = nullptr;
+    delete m_writeNotifier;
+    m_writeNotifier = nullptr;
+    m_writeBuffer.clear();
+
+    if (m_slaveFd >= 0) {
+        ::close(m_slaveFd);
+        m_slaveFd = -1;
+    }
+
+    if (m_masterFd >= 0) {
+        ::close(m_masterFd);
+        m_masterFd = -1;
+    }
+
+    m_portName.clear();
+
+    if (m_serialPort) {
+        m_serialPort->close();
+        delete m_serialPort;
+        m_serialPort = nullptr;
+    }
+
+    m_captureFile.close();
+
+    delete m_replayTimer;
+    m_replayTimer = nullptr;
+    delete m_replayStallTimer;
+    m_replayStallTimer = nullptr;
+    m_replayData.clear();
+    m_replayPosition = 0;
+    m_replayExpectedBytes = 0;
+    m_replayReceivedBytes = 0;
+    m_replayWaiting = false;
+}
+
+void ZigbeeSerialProxy::writeMaster(const QByteArray &data)
+{
+    m_writeBuffer.append(data);
+    onMasterReadyWrite();
+}
+
+void ZigbeeSerialProxy::writeRecord(RecordType type, const QByteArray &data)
+{
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << static_cast<quint8>(type) << m_captureClock.nsecsElapsed() / 1000 << static_cast<quint16>(data.size());
+    stream.writeRawData(data.constData(), data.size());
+
+    m_captureFile.write(record);
+    m_captureFile.flush();
+}
+
+void ZigbeeSerialProxy::onMasterReadyRead()
+{
+    char buffer[512];
+    ssize_t length = ::read(m_masterFd, buffer, sizeof(buffer));
+    if (length <= 0)
+        return;
+
+    // Commands of the network manager, in replay mode they release the recorded replies
+    QByteArray data(buffer, static_cast<int>(length));
+    if (m_serialPort) {
+        if (!m_serialPort->isOpen())
+            return;
+
+        writeRecord(RecordToCoordinator, data);
+        m_serialPort->write(data);
+    } else if (m_replayTimer) {
+        m_replayReceivedBytes += data.size();
+        if (m_replayWaiting && m_replayReceivedBytes >= m_replayExpectedBytes) {
+            m_replayStallTimer->stop();
+            replayNext();
+        }
+    }
+}
+
+void ZigbeeSerialProxy::onMasterReadyWrite()
+{
+    while (!m_writeBuffer.isEmpty()) {
+        ssize_t written = ::write(m_masterFd, m_writeBuffer.constData(), static_cast<size_t>(m_writeBuffer.size()));
+        if (written <= 0)
+            break;
+
+        m_writeBuffer.remove(0, static_cast<int>(written));
+    }
+
+    m_writeNotifier->setEnabled(!m_writeBuffer.isEmpty());
+
+    // As fast as possible means as fast as the network manager reads
+    if (m_replayTimer && !m_replayRealTime && m_writeBuffer.isEmpty() && !m_replayTimer->isActive()) {
+        m_replayTimer->start(0);
+    }
+}
+
+void ZigbeeSerialProxy::onSerialPortReadyRead()
+{
+    QByteArray data = m_serialPort->readAll();
+    writeRecord(RecordFromCoordinator, data);
+    writeMaster(data);
+}
+
+void ZigbeeSerialProxy::onSerialPortError(QSerialPort::SerialPortError error)
+{
+    if (error == QSerialPort::NoError)
+        return;
+
+    qCWarning(dcZigbee()) << "Serial port error, stop capturing to" << m_captureFile.fileName() << error << m_serialPort->errorString();
+    disconnect(m_serialPort, &QSerialPort::readyRead, this, &ZigbeeSerialProxy::onSerialPortReadyRead);
+    m_serialPort->close();
+    m_captureFile.close();
+}
+
+void ZigbeeSerialProxy::onReplayStalled()
+{
+    qCWarning(dcZigbee()) << "Serial replay diverged, the network manager sent" << m_replayReceivedBytes << "of" << m_replayExpectedBytes << "bytes. Continuing anyways.";
+    m_replayReceivedBytes = m_replayExpectedBytes;
+    replayNext();
+}
+
+void ZigbeeSerialProxy::replayNext()
+{
+    while (m_replayPosition + recordHeaderSize <= m_replayData.size()) {
+        const char *record = m_replayData.constData() + m_replayPosition;
+        RecordType type = static_cast<RecordType>(record[0]);
+        qint64 timestamp = qFromLittleEndian<qint64>(record + 1);
+        quint16 length = qFromLittleEndian<quint16>(record + 9);
+        if (m_replayPosition + recordHeaderSize + length > m_replayData.size())
+            break;
+
+        // A new session starts its timestamps at 0 again
+        if (type == RecordSession) {
+            m_replaySessionStart = m_replayClock.nsecsElapsed() / 1000;
+            m_replayPosition += recordHeaderSize + length;
+            continue;
+        }
+
+        if (type == RecordToCoordinator) {
+            m_replayExpectedBytes += length;
+            m_replayPosition += recordHeaderSize + length;
+            continue;
+        }
+
+        // Replies wait for their requests, the recorded timing continues from there
+        if (m_replayReceivedBytes < m_replayExpectedBytes) {
+            m_replayWaiting = true;
+            if (!m_replayStallTimer->isActive())
+                m_replayStallTimer->start();
+            return;
+        }
+
+        if (m_replayWaiting) {
+            m_replayWaiting = false;
+            m_replaySessionStart = m_replayClock.nsecsElapsed() / 1000 - timestamp;
+        }
+
+        if (m_replayRealTime) {
+            qint64 due = (m_replaySessionStart + timestamp) / 1000 - m_replayClock.elapsed();
+            if (due > 0) {
+                m_replayTimer->start(static_cast<int>(due));
+                return;
+            }
+        }
+
+        m_replayPosition += recordHeaderSize + length;
+        if (type != RecordFromCoordinator)
+            continue;
+
+        // As fast as possible continues once the network manager read it
+        writeMaster(QByteArray(record + recordHeaderSize, length));
+        if (!m_replayRealTime)
+            return;
+    }
+
+    if (m_replayPosition + recordHeaderSize > m_replayData.size()) {
+        qCDebug(dcZigbee()) << "Serial capture replay finished";
+    }
+}
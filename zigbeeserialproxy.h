@@ -0,0 +1,110 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEESERIALPROXY_H
+#define ZIGBEESERIALPROXY_H
+
+#include <QFile>
+#include <QTimer>
+#include <QObject>
+#include <QSerialPort>
+#include <QElapsedTimer>
+#include <QSocketNotifier>
+
+// Sits on a pseudo terminal between the network manager and the coordinator. It either
+// forwards the traffic to the real serial port and appends it to a capture file, or it
+// replays the coordinator side of such a capture, in real time or as fast as possible.
+// A replayed record from the coordinator waits until the network manager sent as many
+// bytes as the capture holds towards the coordinator before it, so the replay doesn't
+// answer requests which have not been sent yet.
+//
+// Capture file, little endian: "ZBCP", version (u16), then records of
+// type (u8), microseconds since the session start (i64), length (u16), data.
+// A session record carries the wall clock start time in msecs (i64) as data.
+class ZigbeeSerialProxy : public QObject
+{
+    Q_OBJECT
+public:
+    enum RecordType : quint8 {
+        RecordFromCoordinator = 0,
+        RecordToCoordinator = 1,
+        RecordSession = 2
+    };
+
+    explicit ZigbeeSerialProxy(QObject *parent = nullptr);
+    ~ZigbeeSerialProxy() override;
+
+    bool startCapture(const QString &serialPortName, qint32 baudrate, const QString &captureFileName);
+    bool startReplay(const QString &captureFileName, bool realTime);
+
+    // The pseudo terminal the network manager has to open
+    QString portName() const;
+
+private:
+    int m_masterFd = -1;
+    int m_slaveFd = -1;
+    QString m_portName;
+    QSocketNotifier *m_readNotifier = nullptr;
+    QSocketNotifier *m_writeNotifier = nullptr;
+    QByteArray m_writeBuffer;
+
+    // Capture
+    QSerialPort *m_serialPort = nullptr;
+    QFile m_captureFile;
+    QElapsedTimer m_captureClock;
+
+    // Replay
+    QByteArray m_replayData;
+    int m_replayPosition = 0;
+    bool m_replayRealTime = true;
+    qint64 m_replaySessionStart = 0;
+    QTimer *m_replayTimer = nullptr;
+    QElapsedTimer m_replayClock;
+    qint64 m_replayExpectedBytes = 0;
+    qint64 m_replayReceivedBytes = 0;
+    bool m_replayWaiting = false;
+    QTimer *m_replayStallTimer = nullptr;
+
+    bool openPseudoTerminal();
+    void close();
+    void writeMaster(const QByteArray &data);
+    void writeRecord(RecordType type, const QByteArray &data);
+
+private slots:
+    void onMasterReadyRead();
+    void onMasterReadyWrite();
+    void onSerialPortReadyRead();
+    void onSerialPortError(QSerialPort::SerialPortError error);
+    void onReplayStalled();
+    void replayNext();
+};
+
+#endif // ZIGBEESERIALPROXY_H
@@ -0,0 +1,84 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeesetupqueue.h"
+#include "extern-plugininfo.h"
+
+ZigbeeSetupQueue::ZigbeeSetupQueue(ZigbeeTimerWheel *timerWheel, int timeout, QObject *parent) :
+    QObject(parent),
+    m_timerWheel(timerWheel),
+    m_timeout(timeout)
+{
+
+}
+
+void ZigbeeSetupQueue::park(quint64 ieeeAddress, ThingSetupInfo *info)
+{
+    // A new setup for the same node replaces the old one
+    ThingSetupInfo *previousInfo = take(ieeeAddress);
+    if (previousInfo) {
+        previousInfo->finish(Thing::ThingErrorThingInUse);
+    }
+
+    qCDebug(dcZigbee()) << "Waiting for the node of" << info->thing()->name() << "to appear in the network";
+
+    PendingSetup pendingSetup;
+    pendingSetup.info = info;
+    pendingSetup.timeoutTimer = m_timerWheel->start(m_timeout, [this, ieeeAddress](){
+        PendingSetup pendingSetup = m_pendingSetups.take(ieeeAddress);
+        qCWarning(dcZigbee()) << "The node of" << pendingSetup.info->thing()->name() << "did not appear in the network";
+        // nymea looks up the display message in the context of the plugin class
+        pendingSetup.info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TRANSLATE_NOOP("IntegrationPluginZigbee", "The device is not available in the ZigBee network."));
+    });
+    m_pendingSetups.insert(ieeeAddress, pendingSetup);
+
+    connect(info, &ThingSetupInfo::aborted, this, [this, ieeeAddress, info](){
+        if (m_pendingSetups.value(ieeeAddress).info == info) {
+            m_timerWheel->cancel(m_pendingSetups.take(ieeeAddress).timeoutTimer);
+        }
+    });
+}
+
+ThingSetupInfo *ZigbeeSetupQueue::take(quint64 ieeeAddress)
+{
+    if (!m_pendingSetups.contains(ieeeAddress))
+        return nullptr;
+
+    PendingSetup pendingSetup = m_pendingSetups.take(ieeeAddress);
+    m_timerWheel->cancel(pendingSetup.timeoutTimer);
+    disconnect(pendingSetup.info, &ThingSetupInfo::aborted, this, nullptr);
+    return pendingSetup.info;
+}
+
+bool ZigbeeSetupQueue::isEmpty() const
+{
+    return m_pendingSetups.isEmpty();
+}
@@ -28,44 +28,40 @@
 *
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#ifndef XIAOMIBUTTONSENSOR_H
-#define XIAOMIBUTTONSENSOR_H
 
+#ifndef ZIGBEESETUPQUEUE_H
+#define ZIGBEESETUPQUEUE_H
+
+#include <QHash>
 #include <QObject>
-#include <QTimer>
 
-#include "zigbeenode.h"
+#include <integrations/thingsetupinfo.h>
+
+#include "zigbeetimerwheel.h"
 
-class XiaomiButtonSensor : public QObject
+// Setups of things whose node is not known by the network yet. They get parked by the
+// node ieee address until the node shows up or the timeout fails them.
+class ZigbeeSetupQueue : public QObject
 {
     Q_OBJECT
 public:
-    explicit XiaomiButtonSensor(ZigbeeNode *node, QObject *parent = nullptr);
-
-    bool connected() const;
-    bool pressed() const;
+    explicit ZigbeeSetupQueue(ZigbeeTimerWheel *timerWheel, int timeout, QObject *parent = nullptr);
 
-private:
-    ZigbeeNode *m_node = nullptr;
-    QTimer *m_longPressedTimer = nullptr;
-
-    bool m_connected = false;
-    bool m_pressed = false;
+    void park(quint64 ieeeAddress, ThingSetupInfo *info);
+    ThingSetupInfo *take(quint64 ieeeAddress);
 
-    void setConnected(bool connected);
-    void setPressed(bool pressed);
+    bool isEmpty() const;
 
-signals:
-    void connectedChanged(bool connected);
-    void pressedChanged(bool pressed);
-    void buttonPressed();
-    void buttonLongPressed();
+private:
+    struct PendingSetup {
+        ThingSetupInfo *info = nullptr;
+        ZigbeeTimerWheel::TimerId timeoutTimer = 0;
+    };
 
-private slots:
-    void onLongPressedTimeout();
-    void onNodeConnectedChanged(bool connected);
-    void onClusterAttributeChanged(ZigbeeCluster *cluster, const ZigbeeClusterAttribute &attribute);
+    ZigbeeTimerWheel *m_timerWheel = nullptr;
+    int m_timeout = 0;
 
+    QHash<quint64, PendingSetup> m_pendingSetups;
 };
 
-#endif // XIAOMIBUTTONSENSOR_H
+#endif // ZIGBEESETUPQUEUE_H
@@ -0,0 +1,71 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeethinghandler.h"
+#include "integrationpluginzigbee.h"
+
+ZigbeeThingHandler::ZigbeeThingHandler(IntegrationPluginZigbee *plugin) :
+    QObject(plugin),
+    m_plugin(plugin)
+{
+
+}
+
+void ZigbeeThingHandler::postSetupThing(Thing *thing)
+{
+    Q_UNUSED(thing)
+}
+
+void ZigbeeThingHandler::thingRemoved(Thing *thing)
+{
+    Q_UNUSED(thing)
+}
+
+void ZigbeeThingHandler::executeAction(ThingActionInfo *info)
+{
+    info->finish(Thing::ThingErrorNoError);
+}
+
+quint64 ZigbeeThingHandler::suppressedReportCount() const
+{
+    return 0;
+}
+
+const ZigbeeNodeInfo *ZigbeeThingHandler::findNode(Thing *thing, const ParamTypeId &ieeeAddressParamTypeId) const
+{
+    // Get the parent controller and node for this device
+    ZigbeeNetworkThread *zigbeeNetwork = m_plugin->findParentController(thing);
+    if (!zigbeeNetwork)
+        return nullptr;
+
+    ZigbeeAddress ieeeAddress(thing->paramValue(ieeeAddressParamTypeId).toString());
+    return zigbeeNetwork->node(ieeeAddress.toUInt64());
+}
@@ -0,0 +1,233 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeetimerwheel.h"
+
+#include <QtAlgorithms>
+
+ZigbeeTimerWheel::ZigbeeTimerWheel(int resolution, int slotCount, QObject *parent) :
+    QObject(parent),
+    m_resolution(qMax(1, resolution))
+{
+    m_slots.resize(qMax(1, slotCount));
+    m_liveCounts.resize(m_slots.count());
+    m_occupied.resize((m_slots.count() + 63) / 64);
+
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setSingleShot(true);
+    m_tickTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_tickTimer, &QTimer::timeout, this, &ZigbeeTimerWheel::onTick);
+}
+
+int ZigbeeTimerWheel::resolution() const
+{
+    return m_resolution;
+}
+
+ZigbeeTimerWheel::TimerId ZigbeeTimerWheel::start(int msec, Callback callback)
+{
+    // While ticking, the clock keeps running for the slots still to be processed
+    if (m_entries.isEmpty() && !m_ticking) {
+        m_clock.start();
+        m_lastTick = 0;
+    }
+
+    // The wheel only moves when it gets woken up, count from now instead of the last tick
+    int elapsedTicks = static_cast<int>((m_clock.elapsed() - m_lastTick) / m_resolution);
+    int ticks = elapsedTicks + qMax(1, (msec + m_resolution - 1) / m_resolution);
+
+    TimerId timerId = m_nextTimerId++;
+    if (m_nextTimerId == 0)
+        m_nextTimerId = 1;
+
+    Entry entry;
+    entry.rounds = (ticks - 1) / m_slots.count();
+    entry.callback = callback;
+    int slot = (m_currentSlot + ticks) % m_slots.count();
+    addToSlot(timerId, m_entries.insert(timerId, entry).value(), slot);
+
+    // onTick schedules once it is done with all slots
+    if (m_ticking)
+        return timerId;
+
+    qint64 due = slotDue(slot);
+    if (m_nextDue < 0 || due < m_nextDue) {
+        m_nextDue = due;
+        m_tickTimer->start(static_cast<int>(qMax<qint64>(0, due - m_clock.elapsed())));
+    }
+
+    return timerId;
+}
+
+void ZigbeeTimerWheel::cancel(TimerId timerId)
+{
+    QHash<TimerId, Entry>::iterator it = m_entries.find(timerId);
+    if (it == m_entries.end())
+        return;
+
+    // The slot entry gets dropped lazily once the wheel passes it, the slot only stops counting it
+    removeFromSlot(it.value());
+    qint64 due = slotDue(it.value().slot);
+    m_entries.erase(it);
+    if (m_ticking)
+        return;
+
+    if (m_entries.isEmpty()) {
+        clear();
+    } else if (due == m_nextDue) {
+        schedule();
+    }
+}
+
+bool ZigbeeTimerWheel::isActive(TimerId timerId) const
+{
+    return m_entries.contains(timerId);
+}
+
+int ZigbeeTimerWheel::pendingCount() const
+{
+    return m_entries.count();
+}
+
+void ZigbeeTimerWheel::onTick()
+{
+    // All ticks since the last wakeup, the slots in between had nothing due
+    qint64 now = m_clock.elapsed();
+    int ticks = static_cast<int>(qMax<qint64>(1, (now - m_lastTick + m_resolution / 2) / m_resolution));
+
+    m_ticking = true;
+    for (int i = 0; i < ticks && !m_entries.isEmpty(); i++) {
+        // Advanced per slot, so timers started by callbacks count from the slot being processed
+        m_currentSlot = (m_currentSlot + 1) % m_slots.count();
+        m_lastTick += m_resolution;
+
+        QVector<TimerId> slot;
+        slot.swap(m_slots[m_currentSlot]);
+
+        QVector<Callback> expired;
+        foreach (TimerId timerId, slot) {
+            QHash<TimerId, Entry>::iterator it = m_entries.find(timerId);
+            if (it == m_entries.end())
+                continue;
+
+            if (it.value().rounds > 0) {
+                it.value().rounds--;
+                m_slots[m_currentSlot].append(timerId);
+                continue;
+            }
+
+            expired.append(it.value().callback);
+            removeFromSlot(it.value());
+            m_entries.erase(it);
+        }
+
+        // Callbacks may start or cancel timers
+        foreach (const Callback &callback, expired) {
+            callback();
+        }
+    }
+    m_ticking = false;
+
+    if (m_entries.isEmpty()) {
+        clear();
+        return;
+    }
+
+    schedule();
+}
+
+void ZigbeeTimerWheel::addToSlot(TimerId timerId, Entry &entry, int slot)
+{
+    entry.slot = slot;
+    m_slots[slot].append(timerId);
+    if (m_liveCounts[slot]++ == 0) {
+        m_occupied[slot / 64] |= Q_UINT64_C(1) << (slot % 64);
+    }
+}
+
+void ZigbeeTimerWheel::removeFromSlot(const Entry &entry)
+{
+    if (--m_liveCounts[entry.slot] == 0) {
+        m_occupied[entry.slot / 64] &= ~(Q_UINT64_C(1) << (entry.slot % 64));
+    }
+}
+
+int ZigbeeTimerWheel::nextOccupiedSlot(int from) const
+{
+    // Scans the occupancy words once around, starting with the bits from the slot on
+    int word = from / 64;
+    quint64 bits = m_occupied.at(word) & (~Q_UINT64_C(0) << (from % 64));
+    for (int i = 0; i <= m_occupied.count(); i++) {
+        if (bits)
+            return word * 64 + static_cast<int>(qCountTrailingZeroBits(bits));
+
+        word = (word + 1) % m_occupied.count();
+        bits = m_occupied.at(word);
+    }
+
+    return -1;
+}
+
+qint64 ZigbeeTimerWheel::slotDue(int slot) const
+{
+    // The current slot has been processed already, it is up again after a full turn
+    int distance = (slot - m_currentSlot + m_slots.count()) % m_slots.count();
+    if (distance == 0)
+        distance = m_slots.count();
+
+    return m_lastTick + distance * m_resolution;
+}
+
+void ZigbeeTimerWheel::schedule()
+{
+    // Wake up for the next slot with live timers. Timers due in a later round count in
+    // their slot as well, so there always is one within a turn of the wheel.
+    int slot = nextOccupiedSlot((m_currentSlot + 1) % m_slots.count());
+    if (slot < 0) {
+        m_tickTimer->stop();
+        m_nextDue = -1;
+        return;
+    }
+
+    m_nextDue = slotDue(slot);
+    m_tickTimer->start(static_cast<int>(qMax<qint64>(0, m_nextDue - m_clock.elapsed())));
+}
+
+void ZigbeeTimerWheel::clear()
+{
+    m_tickTimer->stop();
+    m_nextDue = -1;
+    for (int i = 0; i < m_slots.count(); i++) {
+        m_slots[i].clear();
+        m_liveCounts[i] = 0;
+    }
+    m_occupied.fill(0);
+}
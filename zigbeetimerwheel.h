@@ -0,0 +1,97 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEETIMERWHEEL_H
+#define ZIGBEETIMERWHEEL_H
+
+#include <QHash>
+#include <QTimer>
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+
+#include <functional>
+
+// Hashed timer wheel shared by all sensors of the plugin. Starting and cancelling a
+// timer is O(1). A single shot timer wakes the wheel for the next slot holding live
+// timers only, found with a bit scan over the slot occupancy, not on every tick.
+class ZigbeeTimerWheel : public QObject
+{
+    Q_OBJECT
+public:
+    typedef quint32 TimerId;
+    typedef std::function<void()> Callback;
+
+    explicit ZigbeeTimerWheel(int resolution = 50, int slotCount = 256, QObject *parent = nullptr);
+
+    int resolution() const;
+
+    // Calls the callback once after msec, rounded up to the wheel resolution
+    TimerId start(int msec, Callback callback);
+    void cancel(TimerId timerId);
+    bool isActive(TimerId timerId) const;
+
+    int pendingCount() const;
+
+private:
+    struct Entry {
+        int slot = 0;
+        int rounds = 0;
+        Callback callback;
+    };
+
+    QTimer *m_tickTimer = nullptr;
+    QElapsedTimer m_clock;
+    qint64 m_lastTick = 0;
+    int m_resolution = 50;
+
+    QVector<QVector<TimerId>> m_slots;
+    QVector<int> m_liveCounts;
+    QVector<quint64> m_occupied;
+    int m_currentSlot = 0;
+    qint64 m_nextDue = -1;
+    bool m_ticking = false;
+
+    QHash<TimerId, Entry> m_entries;
+    TimerId m_nextTimerId = 1;
+
+    void addToSlot(TimerId timerId, Entry &entry, int slot);
+    void removeFromSlot(const Entry &entry);
+    int nextOccupiedSlot(int from) const;
+    qint64 slotDue(int slot) const;
+    void schedule();
+    void clear();
+
+private slots:
+    void onTick();
+};
+
+#endif // ZIGBEETIMERWHEEL_H
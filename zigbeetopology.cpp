@@ -0,0 +1,145 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeetopology.h"
+#include "zigbeeaddress.h"
+#include "extern-plugininfo.h"
+
+#include <QDateTime>
+#include <algorithm>
+
+void ZigbeeTopology::updateNeighbors(quint16 shortAddress, const QList<ZigbeeNeighbor> &neighbors)
+{
+    if (!m_nodes.contains(shortAddress)) {
+        Node node;
+        node.shortAddress = shortAddress;
+        node.deviceType = shortAddress == 0x0000 ? ZigbeeNeighbor::DeviceTypeCoordinator : ZigbeeNeighbor::DeviceTypeRouter;
+        m_nodes.insert(shortAddress, node);
+    }
+
+    // The new table replaces everything this node reported before
+    QHash<quint32, Link>::iterator it = m_links.begin();
+    while (it != m_links.end()) {
+        if (it.value().from == shortAddress) {
+            it = m_links.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    foreach (const ZigbeeNeighbor &neighbor, neighbors) {
+        Node &node = m_nodes[neighbor.shortAddress];
+        node.shortAddress = neighbor.shortAddress;
+        node.ieeeAddress = neighbor.ieeeAddress;
+        node.depth = neighbor.depth;
+        node.deviceType = neighbor.deviceType;
+
+        Link link;
+        link.from = shortAddress;
+        link.to = neighbor.shortAddress;
+        link.linkQuality = neighbor.linkQuality;
+        link.relationship = neighbor.relationship;
+        link.timestamp = timestamp;
+        m_links.insert(static_cast<quint32>(shortAddress) << 16 | neighbor.shortAddress, link);
+    }
+}
+
+void ZigbeeTopology::clear()
+{
+    m_nodes.clear();
+    m_links.clear();
+}
+
+QList<ZigbeeTopology::Node> ZigbeeTopology::nodes() const
+{
+    return m_nodes.values();
+}
+
+QList<ZigbeeTopology::Link> ZigbeeTopology::links() const
+{
+    return m_links.values();
+}
+
+QList<ZigbeeTopology::Link> ZigbeeTopology::links(quint16 shortAddress) const
+{
+    QList<Link> links;
+    foreach (const Link &link, m_links) {
+        if (link.from == shortAddress || link.to == shortAddress) {
+            links.append(link);
+        }
+    }
+    return links;
+}
+
+QList<ZigbeeTopology::Link> ZigbeeTopology::weakLinks(quint8 linkQuality) const
+{
+    QList<Link> links;
+    foreach (const Link &link, m_links) {
+        if (link.linkQuality < linkQuality) {
+            links.append(link);
+        }
+    }
+
+    std::sort(links.begin(), links.end(), [](const Link &a, const Link &b){
+        return a.linkQuality < b.linkQuality;
+    });
+    return links;
+}
+
+QByteArray ZigbeeTopology::toDot() const
+{
+    static const char *shapes[] = { "doublecircle", "box", "ellipse", "plaintext" };
+
+    QByteArray dot = "digraph zigbee {\n";
+    foreach (const Node &node, m_nodes) {
+        dot += QString("  n%1 [label=\"0x%2\\n%3\\ndepth %4\" shape=%5];\n")
+                .arg(node.shortAddress)
+                .arg(node.shortAddress, 4, 16, QChar('0'))
+                .arg(ZigbeeAddress(node.ieeeAddress).toString())
+                .arg(node.depth)
+                .arg(shapes[node.deviceType]).toUtf8();
+    }
+    foreach (const Link &link, m_links) {
+        dot += QString("  n%1 -> n%2 [label=\"%3\"];\n").arg(link.from).arg(link.to).arg(link.linkQuality).toUtf8();
+    }
+    dot += "}\n";
+    return dot;
+}
+
+void ZigbeeTopology::dump() const
+{
+    qCInfo(dcZigbee()) << "Topology," << m_nodes.count() << "nodes and" << m_links.count() << "links, weak links:";
+    foreach (const Link &link, weakLinks(64)) {
+        qCInfo(dcZigbee()).noquote() << "   " << QString("0x%1 -> 0x%2").arg(link.from, 4, 16, QChar('0')).arg(link.to, 4, 16, QChar('0'))
+                                     << "LQI" << link.linkQuality;
+    }
+}
@@ -0,0 +1,81 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEETOPOLOGY_H
+#define ZIGBEETOPOLOGY_H
+
+#include <QHash>
+#include <QList>
+
+#include "zigbeenodeinfo.h"
+
+// Mesh topology as seen by the neighbor tables of the routers. Gets updated one neighbor
+// table at a time while the crawler walks the network, so it can be queried at any time.
+class ZigbeeTopology
+{
+public:
+    struct Node {
+        quint16 shortAddress = 0;
+        quint64 ieeeAddress = 0;
+        quint8 depth = 0;
+        ZigbeeNeighbor::DeviceType deviceType = ZigbeeNeighbor::DeviceTypeUnknown;
+    };
+
+    // A link as reported by the neighbor table of "from"
+    struct Link {
+        quint16 from = 0;
+        quint16 to = 0;
+        quint8 linkQuality = 0;
+        ZigbeeNeighbor::Relationship relationship = ZigbeeNeighbor::RelationshipNone;
+        qint64 timestamp = 0;
+    };
+
+    void updateNeighbors(quint16 shortAddress, const QList<ZigbeeNeighbor> &neighbors);
+    void clear();
+
+    QList<Node> nodes() const;
+    QList<Link> links() const;
+    QList<Link> links(quint16 shortAddress) const;
+
+    // Links with a link quality below the given one, weakest first
+    QList<Link> weakLinks(quint8 linkQuality) const;
+
+    // Graphviz representation of the whole mesh
+    QByteArray toDot() const;
+    void dump() const;
+
+private:
+    QHash<quint16, Node> m_nodes;
+    // By from << 16 | to
+    QHash<quint32, Link> m_links;
+};
+
+#endif // ZIGBEETOPOLOGY_H
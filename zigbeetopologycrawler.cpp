@@ -0,0 +1,187 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeetopologycrawler.h"
+#include "zigbeenetworkmanager.h"
+#include "extern-plugininfo.h"
+
+#include <QTimer>
+#include <QDataStream>
+#include <QSharedPointer>
+
+ZigbeeTopologyCrawler::ZigbeeTopologyCrawler(ZigbeeNetworkManager *networkManager, ZigbeeCommandScheduler *commandScheduler, QAtomicInt *pendingCommands, QObject *parent) :
+    QObject(parent),
+    m_networkManager(networkManager),
+    m_commandScheduler(commandScheduler),
+    m_pendingCommands(pendingCommands)
+{
+
+}
+
+bool ZigbeeTopologyCrawler::isRunning() const
+{
+    return m_inFlight > 0 || !m_pending.isEmpty();
+}
+
+void ZigbeeTopologyCrawler::start()
+{
+    if (isRunning())
+        return;
+
+    qCDebug(dcZigbee()) << "Start crawling the network topology";
+    m_visited.clear();
+    m_visited.insert(0x0000);
+    m_pending.append(0x0000);
+    requestNext();
+}
+
+void ZigbeeTopologyCrawler::requestNext()
+{
+    while (m_inFlight < maxInFlight && !m_pending.isEmpty()) {
+        request(m_pending.takeFirst());
+    }
+
+    if (!isRunning()) {
+        qCDebug(dcZigbee()) << "Finished crawling the network topology," << m_visited.count() << "routers visited";
+        emit finished();
+    }
+}
+
+void ZigbeeTopologyCrawler::request(quint16 shortAddress, quint8 startIndex)
+{
+    // The pages of one table share the in flight slot of the node
+    if (startIndex == 0) {
+        m_inFlight++;
+    }
+    m_pendingCommands->ref();
+
+    m_commandScheduler->enqueue(ZigbeeCommandScheduler::PriorityMaintenance, shortAddress, 0, [this, shortAddress, startIndex]() -> ZigbeeInterfaceReply * {
+        // Management LQI request: target address and start index
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << shortAddress << startIndex;
+
+        ZigbeeInterfaceRequest request(ZigbeeInterfaceMessage(Zigbee::MessageTypeManagementLqiRequest, data));
+        request.setDescription("Management LQI request");
+        request.setExpectedAdditionalMessageType(Zigbee::MessageTypeManagementLqiResponse);
+        request.setTimoutIntervall(requestTimeout);
+        ZigbeeInterfaceReply *reply = m_networkManager->controller()->sendRequest(request);
+
+        // Whichever comes first, the reply or the timeout. The timeout starts once the
+        // request is sent, the time waiting in the scheduler does not count.
+        QSharedPointer<bool> done(new bool(false));
+        QTimer::singleShot(requestTimeout, this, [this, shortAddress, done](){
+            if (*done)
+                return;
+
+            qCDebug(dcZigbee()) << "Neighbor table request for" << shortAddress << "timed out";
+            *done = true;
+            finishRequest(shortAddress);
+        });
+
+        connect(reply, &ZigbeeInterfaceReply::finished, this, [this, shortAddress, startIndex, reply, done](){
+            if (*done)
+                return;
+
+            *done = true;
+            int nextIndex = processReply(shortAddress, startIndex, reply);
+            if (nextIndex < 0) {
+                finishRequest(shortAddress);
+                return;
+            }
+
+            request(shortAddress, static_cast<quint8>(nextIndex));
+        });
+        return reply;
+    });
+}
+
+int ZigbeeTopologyCrawler::processReply(quint16 shortAddress, quint8 startIndex, ZigbeeInterfaceReply *reply)
+{
+    if (reply->status() != ZigbeeInterfaceReply::StatusSuccess) {
+        qCDebug(dcZigbee()) << "Could not read the neighbor table of" << shortAddress;
+        return -1;
+    }
+
+    // Management LQI response: sequence number, status, table entries, list count, start index
+    // and the list of neighbors
+    QDataStream stream(reply->additionalMessage().data());
+    quint8 sequenceNumber = 0; quint8 status = 0; quint8 tableEntries = 0; quint8 listCount = 0; quint8 responseIndex = 0;
+    stream >> sequenceNumber >> status >> tableEntries >> listCount >> responseIndex;
+    if (stream.status() != QDataStream::Ok || status != 0) {
+        qCDebug(dcZigbee()) << "Invalid neighbor table response from" << shortAddress << "status" << status;
+        return -1;
+    }
+
+    if (responseIndex != startIndex) {
+        qCDebug(dcZigbee()) << "Neighbor table response from" << shortAddress << "starts at" << responseIndex << "instead of" << startIndex;
+        return -1;
+    }
+
+    QList<ZigbeeNeighbor> &neighbors = m_neighbors[shortAddress];
+    for (int i = 0; i < listCount; i++) {
+        ZigbeeNeighbor neighbor;
+        quint64 extendedPanId = 0; quint8 bitmap = 0;
+        stream >> neighbor.shortAddress >> extendedPanId >> neighbor.ieeeAddress >> neighbor.depth >> neighbor.linkQuality >> bitmap;
+        if (stream.status() != QDataStream::Ok)
+            return -1;
+
+        neighbor.deviceType = static_cast<ZigbeeNeighbor::DeviceType>(bitmap & 0x03);
+        neighbor.relationship = static_cast<ZigbeeNeighbor::Relationship>((bitmap >> 4) & 0x03);
+        neighbor.rxOnWhenIdle = ((bitmap >> 6) & 0x03) == 1;
+        neighbors.append(neighbor);
+
+        // Sleeping end devices have no neighbor table of their own
+        if (neighbor.deviceType == ZigbeeNeighbor::DeviceTypeRouter && !m_visited.contains(neighbor.shortAddress)) {
+            m_visited.insert(neighbor.shortAddress);
+            m_pending.append(neighbor.shortAddress);
+        }
+    }
+
+    // An empty page would request the same index again
+    int nextIndex = startIndex + listCount;
+    if (listCount == 0 || nextIndex >= tableEntries)
+        return -1;
+
+    qCDebug(dcZigbee()) << "Got" << nextIndex << "of" << tableEntries << "neighbors of" << shortAddress << ", requesting the next page";
+    return nextIndex;
+}
+
+void ZigbeeTopologyCrawler::finishRequest(quint16 shortAddress)
+{
+    // Pages received before a failure are still valid neighbors
+    if (m_neighbors.contains(shortAddress)) {
+        emit neighborTableReceived(shortAddress, m_neighbors.take(shortAddress));
+    }
+
+    m_inFlight--;
+    requestNext();
+}
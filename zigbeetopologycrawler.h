@@ -0,0 +1,83 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEETOPOLOGYCRAWLER_H
+#define ZIGBEETOPOLOGYCRAWLER_H
+
+#include <QSet>
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include "zigbeenodeinfo.h"
+#include "zigbeecommandscheduler.h"
+
+class ZigbeeNetworkManager;
+class ZigbeeInterfaceReply;
+
+// Walks the mesh starting at the coordinator by requesting the neighbor table (Mgmt_Lqi_req)
+// of every router it finds. The requests take the maintenance lane of the command scheduler,
+// only a few of them are outstanding at a time. Long tables get requested page by page using
+// the start index until all entries are known. Lives in the network thread.
+class ZigbeeTopologyCrawler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ZigbeeTopologyCrawler(ZigbeeNetworkManager *networkManager, ZigbeeCommandScheduler *commandScheduler, QAtomicInt *pendingCommands, QObject *parent = nullptr);
+
+    bool isRunning() const;
+    void start();
+
+signals:
+    void neighborTableReceived(quint16 shortAddress, const QList<ZigbeeNeighbor> &neighbors);
+    void finished();
+
+private:
+    static const int maxInFlight = 2;
+    static const int requestTimeout = 15000;
+
+    ZigbeeNetworkManager *m_networkManager = nullptr;
+    ZigbeeCommandScheduler *m_commandScheduler = nullptr;
+    QAtomicInt *m_pendingCommands = nullptr;
+
+    QList<quint16> m_pending;
+    QSet<quint16> m_visited;
+    QHash<quint16, QList<ZigbeeNeighbor>> m_neighbors;
+    int m_inFlight = 0;
+
+    void requestNext();
+    void request(quint16 shortAddress, quint8 startIndex = 0);
+    // Returns the start index of the next page or -1 if the table is complete
+    int processReply(quint16 shortAddress, quint8 startIndex, ZigbeeInterfaceReply *reply);
+    void finishRequest(quint16 shortAddress);
+};
+
+#endif // ZIGBEETOPOLOGYCRAWLER_H
@@ -0,0 +1,70 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "zigbeetrace.h"
+#include "zigbeereportqueue.h"
+#include "zigbeelatencyhistogram.h"
+#include "extern-plugininfo.h"
+
+static qint64 s_reportTimestamp = 0;
+static ZigbeeLatencyHistogram s_histograms[ZigbeeTrace::HopCount];
+
+void ZigbeeTrace::beginReport(qint64 timestamp)
+{
+    s_reportTimestamp = timestamp;
+}
+
+void ZigbeeTrace::endReport()
+{
+    s_reportTimestamp = 0;
+}
+
+void ZigbeeTrace::record(Hop hop)
+{
+    // Timers and initial values are not caused by a report
+    if (s_reportTimestamp == 0)
+        return;
+
+    s_histograms[hop].add(ZigbeeReportQueue::timestamp() - s_reportTimestamp);
+}
+
+void ZigbeeTrace::dump()
+{
+    static const char *hopNames[HopCount] = { "dispatched", "decoded", "state changed", "event emitted" };
+    qCInfo(dcZigbee()) << "Report latency since receive [us]:";
+    for (int hop = 0; hop < HopCount; hop++) {
+        const ZigbeeLatencyHistogram &histogram = s_histograms[hop];
+        qCInfo(dcZigbee()).nospace() << "    " << hopNames[hop] << ": count " << histogram.count()
+                                     << ", p50 " << histogram.percentile(0.5)
+                                     << ", p95 " << histogram.percentile(0.95)
+                                     << ", p99 " << histogram.percentile(0.99);
+    }
+}
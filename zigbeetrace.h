@@ -0,0 +1,70 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef ZIGBEETRACE_H
+#define ZIGBEETRACE_H
+
+#include <QtGlobal>
+
+// Per hop latency of attribute reports, measured from the monotonic receive timestamp
+// of the report currently being dispatched. Only used from the main thread.
+//
+// The tracepoints compile to nothing unless the plugin is built with CONFIG+=zigbee_tracing,
+// zigbeetrace.cpp is only part of such builds.
+class ZigbeeTrace
+{
+public:
+    enum Hop {
+        HopDispatched,
+        HopDecoded,
+        HopStateChanged,
+        HopEventEmitted,
+        HopCount
+    };
+
+    static void beginReport(qint64 timestamp);
+    static void endReport();
+    static void record(Hop hop);
+
+    static void dump();
+};
+
+#ifdef ZIGBEE_TRACING
+#define ZIGBEE_TRACE_BEGIN(timestamp) ZigbeeTrace::beginReport(timestamp)
+#define ZIGBEE_TRACE_END() ZigbeeTrace::endReport()
+#define ZIGBEE_TRACE(hop) ZigbeeTrace::record(ZigbeeTrace::hop)
+#else
+#define ZIGBEE_TRACE_BEGIN(timestamp) do { } while (false)
+#define ZIGBEE_TRACE_END() do { } while (false)
+#define ZIGBEE_TRACE(hop) do { } while (false)
+#endif
+
+#endif // ZIGBEETRACE_H